@@ -22,37 +22,59 @@
 */
 
 #include <cmath>
+#include <cstdint>
+#include <vector>
 
 namespace john {
 
+	class BitTree;
+
 	class BitNode {
+	/*
+		A BitNode is one node of a binary partition of the real line. A leaf is 
+		one interval; splitting it places a boundary between its two children at 
+		a golden ratio of its range, nearer the lower end if value is false. 
+		branch_leaves counts the leaves below (or 1 for a leaf). BitNodes are the 
+		mutable form of a BitTree, which answers queries from a flattened copy. 
+		
+		BitNodes live in an arena, a vector owned by the BitTree, and refer to one
+		another by 32-bit index into it. The root is at index 0, which no node 
+		can have as a child, so 0 also means "none". The two children of a node 
+		are allocated together, so only the first is stored. A BitNode is 16 
+		bytes and trivially copyable: copying a tree is one memcpy, and freeing 
+		it is one deallocation. Functions that follow links therefore take the 
+		arena and the node's index. 
+		
+		Moving a boundary moves every boundary below it, so update_boundary 
+		recomputes the whole subtree from the range it is given. split() does 
+		not count leaves, so that a batch of splits can count each ancestor once
+		(see BitTree). 
+	*/
 	private:
-		BitNode* parent, child_zero, child_one;
-		unsigned short branch_leaves; 
+		std::uint32_t parent; //0 for the root
+		std::uint32_t child_zero; //child_one is next to it; 0 for a leaf
 		float boundary;
-		
-		float infer_boundary() const;
+		unsigned short branch_leaves; 
 		
 	public:
 		bool value;
 		
-		BitNode();
-		BitNode(BitNode* pParent, const bool child);
-		BitNode(const bool bValue, const float range, BitNode* child0=NULL, BitNode* child1=NULL);
-		BitNode(const BitNode& rhs);
-		BitNode(BitNode&& rhs);
-		BitNode& operator=(const BitNode& rhs);
-		BitNode& operator=(BitNode&& rhs);
-		~BitNode();
+		BitNode() 
+			: parent(0), child_zero(0), boundary(0.0), branch_leaves(1), value(false) {}
+		BitNode(const std::uint32_t nParent) 
+			: parent(nParent), child_zero(0), boundary(0.0), branch_leaves(1), value(false) {}
+		
+		bool is_leaf() const { return child_zero == 0; }
+		std::uint32_t child_one() const { return child_zero + 1; }
 		
-		void split(const bool bValue);
-		void update_boundary(const float lower_bound, const float upper_bound);
-		void update_leaves();
-		unsigned short query(const float number) const;
+		static void split(std::vector<BitNode>& nodes, const std::uint32_t index, const bool bValue);
+		static void update_boundary(BitNode* nodes, const std::uint32_t index, 
+					    const float lower_bound, const float upper_bound);
+		
+		friend class BitTree;
 		
 	}; //class BitNode
 	
 } //namespace john
 
 #endif
-
@@ -18,10 +18,360 @@
     e-mail: jackwhall7@gmail.com
 */
 
+#include <algorithm>
+#include <functional>
+#include <limits>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#include "BitTree.h"
+
 namespace john {
 
+	BitTree::BitTree(const float fLower, const float fUpper) 
+		: nodes(1), upper_bound(fUpper), lower_bound(fLower), boundaries(), ranks(), ordered(), 
+		  pending(), levels(0) {
+		flatten();
+	}
+	
+	BitTree::BitTree(const float fLower, const float fUpper, const float* sample, 
+			 const std::size_t count, const unsigned int leaf_size) 
+		: nodes(1), upper_bound(fUpper), lower_bound(fLower), boundaries(), ranks(), ordered(), 
+		  pending(), levels(0) {
+		//see class comment
+		std::vector<float> sorted;
+		if( !std::is_sorted(sample, sample + count) ) {
+			sorted.assign(sample, sample + count);
+			std::sort( sorted.begin(), sorted.end() );
+			sample = sorted.data();
+		}
+		
+		nodes.reserve( 2*count/std::max(leaf_size, 1u) + 1 );
+		load(sample, sample + count, leaf_size);
+		flatten();
+	}
+	
+	bool BitTree::split(const float number, const bool bValue) {
+		return split(&number, &bValue, 1) == 1;
+	}
+	
+	std::size_t BitTree::split(const float* numbers, const bool* values, const std::size_t count) {
+		/*
+		Splits the leaf containing each number in turn, with the matching value, 
+		until the tree has max_leaves leaves. Each descent tracks the leaf's 
+		range, for the new boundary. The split nodes are remembered so that 
+		their ancestors can be recounted together. Every split adds one leaf, 
+		and a tree of n leaves has 2n-1 nodes, so the arena's size gives the 
+		count while branch_leaves is out of date. The new boundaries go to 
+		pending, unless there are enough of them to rebuild the flat copy. 
+		*/
+		std::vector<std::uint32_t> changed;
+		changed.reserve(count);
+		std::size_t i;
+		for(i=0; i<count && (nodes.size() + 1)/2 < max_leaves; ++i) {
+			std::uint32_t index = 0;
+			float lower = lower_bound, upper = upper_bound;
+			while( !nodes[index].is_leaf() ) {
+				const BitNode& node = nodes[index];
+				if(numbers[i] > node.boundary) {
+					lower = node.boundary;
+					index = node.child_one();
+				} else {
+					upper = node.boundary;
+					index = node.child_zero;
+				}
+			}
+			
+			BitNode::split(nodes, index, values[i]);
+			BitNode::update_boundary(nodes.data(), index, lower, upper);
+			changed.push_back(index);
+		}
+		
+		const std::size_t made = changed.size();
+		if( (pending.size() + made)*(pending.size() + made) > ordered.size() ) {
+			count_leaves(changed);
+			flatten();
+			return i;
+		}
+		
+		for(std::size_t j=0; j<made; ++j) pending.push_back( nodes[ changed[j] ].boundary );
+		std::sort( pending.begin(), pending.end() );
+		count_leaves(changed);
+		return i;
+	}
+	
+	void BitTree::count_leaves(std::vector<std::uint32_t>& changed) {
+		/*
+		Recounts the leaves of the changed nodes (leaves just split) and of all 
+		their ancestors, each once. Walking up from each changed node, a count 
+		of 0 (which no real node has) marks an ancestor already collected, so 
+		the walk stops there. Children are always after their parents in the 
+		arena, so recounting in descending index order finishes every child 
+		before its parent. A lone split just adds a leaf to each ancestor. 
+		*/
+		if(changed.size() == 1) {
+			std::uint32_t index = changed[0];
+			nodes[index].branch_leaves = 2;
+			while(index != 0) {
+				index = nodes[index].parent;
+				++nodes[index].branch_leaves;
+			}
+			return;
+		}
+		
+		std::size_t i, collected = changed.size();
+		for(i=0; i<collected; ++i) nodes[ changed[i] ].branch_leaves = 0;
+		for(i=0; i<collected; ++i) {
+			std::uint32_t index = changed[i];
+			while(index != 0) {
+				index = nodes[index].parent;
+				if(nodes[index].branch_leaves == 0) break;
+				nodes[index].branch_leaves = 0;
+				changed.push_back(index);
+			}
+		}
+		
+		std::sort( changed.begin(), changed.end(), std::greater<std::uint32_t>() );
+		for(std::uint32_t index : changed) {
+			BitNode& node = nodes[index];
+			node.branch_leaves = nodes[node.child_zero].branch_leaves 
+					     + nodes[node.child_one()].branch_leaves;
+		}
+	}
+	
+	void BitTree::load(const float* begin, const float* end, const unsigned int leaf_size) {
+		/*
+		Splits the single leaf of a new tree to fit the sorted sample [begin, end).
+		The queue holds each leaf still to be considered, with its range and its 
+		share of the sample, in the order the leaves were made, so that if the 
+		leaf limit is reached, every part of the sample was divided about as far.
+		Children are always after their parents in the arena, so a backward pass 
+		can count the leaves. 
+		*/
+		struct Part {
+			std::uint32_t index;
+			const float *begin, *end; //of the sample
+			float lower, upper; //of the range
+		};
+		std::vector<Part> queue;
+		queue.reserve( nodes.capacity() );
+		queue.push_back( Part{0, begin, end, lower_bound, upper_bound} );
+		
+		const float ratio = 2.0/(1.0 + sqrt(5));
+		for(std::size_t next=0; next<queue.size(); ++next) {
+			const Part part = queue[next]; //a copy, since the queue grows
+			const std::size_t count = part.end - part.begin;
+			if( count <= leaf_size || *part.begin == *(part.end-1) ) continue;
+			if( (nodes.size() + 1)/2 == max_leaves ) break; //no room for another leaf
+			
+			const float low = part.lower + (1-ratio)*(part.upper - part.lower); //value false
+			const float high = part.lower + ratio*(part.upper - part.lower); //value true
+			if( !(part.lower < low && high < part.upper) ) continue; //too narrow for float
+			
+			//the boundary that leaves the larger smaller side
+			const float* low_split = divide(part.begin, part.end, low);
+			const float* high_split = divide(part.begin, part.end, high);
+			std::size_t low_side = std::min(low_split - part.begin, part.end - low_split);
+			std::size_t high_side = std::min(high_split - part.begin, part.end - high_split);
+			const bool bValue = high_side > low_side;
+			const float boundary = bValue ? high : low;
+			const float* split = bValue ? high_split : low_split;
+			
+			const std::uint32_t child_zero = nodes.size();
+			nodes[part.index].value = bValue;
+			nodes[part.index].boundary = boundary;
+			nodes[part.index].child_zero = child_zero;
+			nodes.push_back( BitNode(part.index) );
+			nodes.push_back( BitNode(part.index) );
+			queue.push_back( Part{child_zero, part.begin, split, part.lower, boundary} );
+			queue.push_back( Part{child_zero + 1, split, part.end, boundary, part.upper} );
+		}
+		
+		for(std::uint32_t i=nodes.size(); i-- > 0; ) {
+			BitNode& node = nodes[i];
+			if( !node.is_leaf() ) 
+				node.branch_leaves = nodes[node.child_zero].branch_leaves 
+						     + nodes[node.child_one()].branch_leaves;
+		}
+	}
+	
+	const float* BitTree::divide(const float* begin, const float* end, const float boundary) {
+		/*
+		Returns the first value above boundary (values on it go to the lower 
+		leaf). Probes from both ends with doubling steps until one probe crosses 
+		the boundary, then binary searches the last step, so the cost is the log 
+		of the smaller side. [lo, hi] always contains the answer. 
+		*/
+		const std::size_t count = end - begin;
+		std::size_t lo = 0, hi = count, step;
+		for(step=1; step<=count && lo<hi; step*=2) {
+			if(begin[step-1] > boundary) {
+				hi = std::min(hi, step - 1);
+				break;
+			}
+			lo = std::max(lo, step);
+			if(begin[count-step] <= boundary) {
+				lo = std::max(lo, count - step + 1);
+				break;
+			}
+			hi = std::min(hi, count - step);
+		}
+		return std::upper_bound(begin + lo, begin + hi, boundary);
+	}
+	
+	void BitTree::flatten() {
+		/*
+		The boundaries of the internal nodes, read in order, are sorted, and the
+		leaf below the i-th of them (from 0) has rank i+1. place() lays them out
+		in Eytzinger order by an in-order walk of the implicit tree 1, 2, 3, ...
+		after them come the +infinity boundaries that complete the last level.
+		Every pending boundary is then in the flat copy. 
+		*/
+		ordered.clear();
+		ordered.reserve(size() - 1);
+		collect(0);
+		pending.clear();
+		
+		for(levels=0; (1u << levels) - 1 < ordered.size(); ++levels);
+		boundaries.assign( 1u << levels, std::numeric_limits<float>::infinity() );
+		ranks.assign( 1u << levels, size() );
+		unsigned int i = 0;
+		place(i, 1);
+		ranks[0] = size(); //numbers above every boundary
+	}
 	
+	void BitTree::collect(const std::uint32_t index) {
+		if( nodes[index].is_leaf() ) return;
+		const BitNode& node = nodes[index];
+		collect(node.child_zero);
+		ordered.push_back(node.boundary);
+		collect(node.child_one());
+	}
+	
+	void BitTree::place(unsigned int& i, const unsigned int k) {
+		//padding keeps the +infinity and the rank of the last leaf it was filled with
+		if(k >= boundaries.size()) return;
+		place(i, 2*k);
+		if(i < ordered.size()) {
+			boundaries[k] = ordered[i];
+			ranks[k] = i + 1;
+		}
+		++i;
+		place(i, 2*k + 1);
+	}
+	
+	unsigned short BitTree::rank_of(unsigned int k) const {
+		/*
+		A descent ends below the last level, at an index whose bits are its 
+		turns. Shifting off its trailing one bits (the right turns since the 
+		last left turn) and the following zero leaves the first boundary at or 
+		above the number, or 0 if there is none. 
+		*/
+#if defined(__GNUC__)
+		k >>= __builtin_ffs(~k);
+#else
+		while(k & 1) k >>= 1;
+		k >>= 1;
+#endif
+		return ranks[k];
+	}
+	
+	unsigned short BitTree::pending_below(const float number) const {
+		//a NaN is below nothing, as in a descent
+		return std::lower_bound(pending.begin(), pending.end(), number) - pending.begin();
+	}
+	
+	unsigned short BitTree::query(const float number) const {
+		//descends, going right past every boundary below number
+		const float* b = boundaries.data();
+		unsigned int k = 1, level;
+		for(level=0; level<levels; ++level) {
+#if defined(__GNUC__)
+			__builtin_prefetch(b + 16*k); //four levels down
+#endif
+			k = 2*k + (b[k] < number);
+		}
+		if( pending.empty() ) return rank_of(k);
+		return rank_of(k) + pending_below(number);
+	}
+	
+	void BitTree::query(const float* numbers, const std::size_t count, unsigned short* out) const {
+		/*
+		Quantizes count numbers, as query() would each. Descents run in groups 
+		in lockstep: every step of a group is a batch of independent loads, 
+		which the processor overlaps, where a lone descent waits for each in 
+		turn. Groups are 64 numbers with AVX2 (8 registers) and 32 without; 
+		smaller groups leave the gathers' latency exposed. 
+		*/
+		const float* b = boundaries.data();
+		std::size_t i = 0;
+		unsigned int j, level;
+		std::uint32_t k[64];
+#if defined(__AVX2__)
+		__m256 x[8];
+		__m256i kv[8];
+		for(; i+64<=count; i+=64) {
+			for(j=0; j<8; ++j) {
+				x[j] = _mm256_loadu_ps(numbers + i + 8*j);
+				kv[j] = _mm256_set1_epi32(1);
+			}
+			for(level=0; level<levels; ++level) {
+				for(j=0; j<8; ++j) {
+					//a true comparison is all ones, -1, so subtracting it goes right
+					__m256 bv = _mm256_i32gather_ps(b, kv[j], 4);
+					kv[j] = _mm256_sub_epi32( _mm256_add_epi32(kv[j], kv[j]), 
+								  _mm256_castps_si256(_mm256_cmp_ps(bv, x[j], _CMP_LT_OQ)) );
+				}
+			}
+			for(j=0; j<8; ++j) _mm256_storeu_si256( reinterpret_cast<__m256i*>(k + 8*j), kv[j] );
+			for(j=0; j<64; ++j) out[i+j] = rank_of(k[j]);
+		}
+#endif
+		float y[32];
+		for(; i+32<=count; i+=32) {
+			for(j=0; j<32; ++j) {
+				y[j] = numbers[i+j];
+				k[j] = 1;
+			}
+			for(level=0; level<levels; ++level) 
+				for(j=0; j<32; ++j) k[j] = 2*k[j] + (b[k[j]] < y[j]);
+			for(j=0; j<32; ++j) out[i+j] = rank_of(k[j]);
+		}
+		if( !pending.empty() ) 
+			for(std::size_t n=0; n<i; ++n) out[n] += pending_below(numbers[n]);
+		for(; i<count; ++i) out[i] = query(numbers[i]);
+	}
+	
+	void BitTree::query_sorted(const float* numbers, const std::size_t count, 
+				   unsigned short* out) const {
+		/*
+		Quantizes ascending numbers by merging them with the sorted boundaries. 
+		The rank of a number is 1 plus the count of boundaries below it, which 
+		never decreases, so each search starts where the last one ended and 
+		gallops forward: doubling steps, then a binary search of the last step. 
+		The cost is linear in count plus the log of each gap, never more than a 
+		pass over both arrays. Pending boundaries, which are few, are merged in 
+		a step at a time. A NaN gets rank 1, as from query(), and does not move 
+		the merge. 
+		*/
+		const float* first = ordered.data();
+		const float* last = first + ordered.size();
+		const float* p = first; //first boundary not below the previous number
+		std::vector<float>::const_iterator q = pending.begin(); //likewise, in pending
+		std::size_t step;
+		for(std::size_t i=0; i<count; ++i) {
+			const float number = numbers[i];
+			if(number != number) { 
+				out[i] = 1;
+				continue;
+			}
+			if(p != last && *p < number) {
+				for(step=1; step <= std::size_t(last - p) && p[step-1] < number; step*=2) p += step;
+				p = std::lower_bound( p, p + std::min<std::size_t>(step - 1, last - p), number );
+			}
+			while(q != pending.end() && *q < number) ++q;
+			out[i] = (p - first) + (q - pending.begin()) + 1;
+		}
+	}
 
 } //namespace john
-
-
@@ -21,15 +21,108 @@
     e-mail: jackwhall7@gmail.com
 */
 
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "BitNode.h"
+
 namespace john {
 	
 	class BitTree {
+	/*
+		A BitTree quantizes real numbers. Its leaves partition the real line, 
+		and query() gives the rank of the leaf containing a number, counting from
+		1 on the left; a number on a boundary belongs to the lower leaf. The tree
+		grows by splitting leaves, and each boundary divides its node's share of
+		[lower_bound, upper_bound] at a golden ratio (see BitNode). 
+		
+		The BitNodes are only the mutable form of the tree. Queries read a flat 
+		copy of the boundaries, in Eytzinger order:
+		the boundaries sorted, then laid out breadth first, so that the children 
+		of element k are 2k and 2k+1. A descent is then a loop of one comparison 
+		that computes the next index without a branch, the first four levels 
+		share a cache line, and the line sixteen elements ahead can be prefetched 
+		before it is needed. Each element also stores the rank of the leaf just 
+		below its boundary, so no leaf counts are read during a query. The array 
+		is padded to a complete tree with +infinity boundaries (ranked as the 
+		last leaf), so every descent takes exactly levels steps. 
+		
+		Arrays of numbers can be quantized at once. The batch query runs many 
+		descents in lockstep, a level at a time, so their loads overlap instead 
+		of waiting on one another; with AVX2, each step for 8 numbers is one 
+		gather and one compare. If the numbers are sorted, query_sorted instead 
+		merges them with the sorted boundaries, searching forward from the last 
+		answer with doubling steps, in a single pass over both. 
+		
+		The BitNodes are kept in an arena (see BitNode), so a BitTree copies, 
+		moves and frees like the vectors it holds. 
+		
+		A BitTree can also be built in one pass from a sample of values (sorted 
+		or not). Every leaf holding more than leaf_size of the sample is split, 
+		top down, with the value that puts the boundary nearer the sample's 
+		median, until no leaf holds more, a leaf's values are all equal, or its 
+		range is too narrow to split in single precision. Leaves are split 
+		breadth first, each once, and one backward pass over the arena then sets 
+		every leaf count, so nothing is updated split by split. Finding where a 
+		boundary divides the sample searches from both ends, which costs the log 
+		of the smaller side; over the whole tree that sums to linear time. 
+		
+		There are at most max_leaves leaves, since branch_leaves and ranks are 
+		16-bit. Past that, load() leaves the deepest splits unmade, and split() 
+		refuses: it returns false, or the batch stops and returns how many of 
+		its numbers were split. 
+		
+		Splits can also be made in batches, with the same result as making them 
+		one after another. Leaves are counted once the batch is done, and each 
+		ancestor of a new leaf is recounted only once. 
+		
+		Rebuilding the flat copy costs a pass over the whole tree, so it is not 
+		done for every split. A split only adds one boundary, and raises by one 
+		the rank of every number above it. The new boundaries are kept, sorted,
+		in pending, and a query adds the count of those below its number to the 
+		rank read from the flat copy. The flat copy is rebuilt once pending 
+		holds more than the square root of its size, which balances the cost of
+		rebuilding against the length of pending; a stream of single splits 
+		then costs the square root of the tree's size per split, where 
+		rebuilding for each cost the whole size. Queries are const and may run 
+		concurrently, so they never rebuild it themselves. 
+	*/
 	private:
-		BitNode* pRoot;
+		std::vector<BitNode> nodes; //the root first
 		float upper_bound, lower_bound;
+		std::vector<float> boundaries; //Eytzinger order from index 1
+		std::vector<unsigned short> ranks; //of the leaf below each boundary; [0] is the last leaf
+		std::vector<float> ordered; //the boundaries, sorted, without padding
+		std::vector<float> pending; //boundaries since the last flatten(), sorted
+		unsigned int levels; //of the padded Eytzinger tree
+		
+		void flatten(); //rebuilds boundaries and ranks from the BitNodes
+		void collect(const std::uint32_t index);
+		unsigned short pending_below(const float number) const;
+		void count_leaves(std::vector<std::uint32_t>& changed);
+		void place(unsigned int& i, const unsigned int k);
+		unsigned short rank_of(unsigned int k) const; //from the index a descent ends at
+		void load(const float* begin, const float* end, const unsigned int leaf_size);
+		static const float* divide(const float* begin, const float* end, const float boundary);
 		
 	public:
+		static const unsigned short max_leaves = 65535;
+		
+		BitTree(const float fLower, const float fUpper); //one leaf
+		BitTree(const float fLower, const float fUpper, const float* sample, 
+			const std::size_t count, const unsigned int leaf_size=1);
+		BitTree(const BitTree& rhs) = default;
+		BitTree(BitTree&& rhs) = default;
+		BitTree& operator=(const BitTree& rhs) = default;
+		BitTree& operator=(BitTree&& rhs) = default;
+		~BitTree() = default;
 		
+		unsigned short size() const { return nodes[0].branch_leaves; } //number of leaves
+		bool split(const float number, const bool bValue); //the leaf containing number
+		std::size_t split(const float* numbers, const bool* values, const std::size_t count);
+		unsigned short query(const float number) const;
+		void query(const float* numbers, const std::size_t count, unsigned short* out) const;
+		void query_sorted(const float* numbers, const std::size_t count, unsigned short* out) const;
 		
 	}; //class BitTree
 	
@@ -0,0 +1,67 @@
+/*
+    John: an evolutionary algorithm for genetic networks
+    Copyright (C) 2012  Jack Hall
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    e-mail: jackwhall7@gmail.com
+*/
+
+#include <algorithm>
+#include <cassert>
+#include "BlockPool.h"
+
+namespace john {
+
+	BlockPool::BlockPool() 
+		: mutex(), block_units(0), slabs(), free_blocks(), block_count(0) {}
+	
+	void BlockPool::grow() {
+		//blocks are pushed in reverse, so a new slab is handed out front to back
+		const std::size_t slab_blocks = std::max<std::size_t>( 
+			1, slab_bytes / (block_units * sizeof(unit_type)) );
+		slabs.emplace_back( new unit_type[slab_blocks * block_units] );
+		block_count += slab_blocks;
+		free_blocks.reserve(block_count); //room for every block, so deallocate never grows it
+		unit_type* slab = slabs.back().get();
+		for(std::size_t i=slab_blocks; i>0; --i) free_blocks.push_back(slab + (i-1)*block_units);
+	} //grow
+	
+	void* BlockPool::allocate(const std::size_t bytes) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if(block_units == 0) block_units = (bytes + sizeof(unit_type) - 1) / sizeof(unit_type);
+		assert(bytes <= block_units * sizeof(unit_type)); //see class comment
+		if( free_blocks.empty() ) grow();
+		void* block = free_blocks.back();
+		free_blocks.pop_back();
+		return block;
+	} //allocate
+	
+	void BlockPool::deallocate(void* block) {
+		std::lock_guard<std::mutex> lock(mutex);
+		free_blocks.push_back(block);
+	} //deallocate
+	
+	std::size_t BlockPool::capacity() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return block_count;
+	} //capacity
+	
+	std::size_t BlockPool::available() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return free_blocks.size();
+	} //available
+
+} //namespace john
+
@@ -0,0 +1,111 @@
+#ifndef BlockPool_h
+#define BlockPool_h
+
+/*
+    John: an evolutionary algorithm for genetic networks
+    Copyright (C) 2012  Jack Hall
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    e-mail: jackwhall7@gmail.com
+*/
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace john {
+
+	class BlockPool {
+	/*
+		A BlockPool hands out blocks of memory of one size, for small objects that
+		are made and destroyed at a high rate on many threads: SharedChromosome 
+		chunks, genome tables and decoded Phenotype parameters. Like GenomePool, 
+		it takes memory in slabs of about 64 KiB and keeps freed blocks on a free
+		list, most recently freed last, until the pool is destroyed. Once the 
+		number of live blocks has reached its high point, allocating and 
+		deallocating never touch the heap. 
+		
+		The block size is fixed by the first allocation, since the size of what
+		std::allocate_shared allocates (the object and its reference counts) is 
+		only known to the library; asking for a larger block later is an error.
+		allocate and deallocate are thread-safe, under one mutex. Every block 
+		must be given back before the pool is destroyed. 
+		
+		PoolAllocator adapts a BlockPool for std::allocate_shared, so that the 
+		object and its control block come from the pool and go back to it when 
+		the last shared_ptr lets go. 
+	*/
+	private:
+		typedef std::max_align_t unit_type; //every block is aligned for anything
+		static const std::size_t slab_bytes = 1u << 16;
+		
+		mutable std::mutex mutex;
+		std::size_t block_units; //size of a block in units, 0 until the first allocation
+		std::vector< std::unique_ptr<unit_type[]> > slabs;
+		std::vector<void*> free_blocks; //most recently freed last
+		std::size_t block_count; //in all slabs
+		
+		void grow();
+		
+	public:
+		BlockPool();
+		BlockPool(const BlockPool& rhs) = delete;
+		BlockPool& operator=(const BlockPool& rhs) = delete;
+		~BlockPool() = default;
+		
+		void* allocate(const std::size_t bytes);
+		void deallocate(void* block);
+		std::size_t capacity() const; //blocks in all slabs
+		std::size_t available() const; //blocks on the free list
+		
+	}; //class BlockPool
+	
+	template<typename T>
+	class PoolAllocator {
+	/*
+		A minimal allocator for std::allocate_shared. Single objects come from 
+		the pool; arrays, which allocate_shared never asks for, from the heap. 
+	*/
+	public:
+		typedef T value_type;
+		
+		BlockPool* pool;
+		
+		explicit PoolAllocator(BlockPool* pPool) : pool(pPool) {}
+		template<typename U>
+		PoolAllocator(const PoolAllocator<U>& rhs) : pool(rhs.pool) {}
+		
+		T* allocate(const std::size_t n) {
+			if(n == 1) return static_cast<T*>( pool->allocate(sizeof(T)) );
+			return static_cast<T*>( ::operator new(n * sizeof(T)) );
+		}
+		void deallocate(T* p, const std::size_t n) {
+			if(n == 1) pool->deallocate(p);
+			else ::operator delete(p);
+		}
+		
+		template<typename U>
+		bool operator==(const PoolAllocator<U>& rhs) const { return pool == rhs.pool; }
+		template<typename U>
+		bool operator!=(const PoolAllocator<U>& rhs) const { return pool != rhs.pool; }
+		
+	}; //class PoolAllocator
+
+} //namespace john
+
+#endif
+
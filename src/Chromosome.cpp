@@ -0,0 +1,162 @@
+/*
+    John: an evolutionary algorithm for genetic networks
+    Copyright (C) 2012  Jack Hall
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    e-mail: jackwhall7@gmail.com
+*/
+
+namespace john {
+
+	template<unsigned int B>
+	std::uint64_t Chromosome<B>::field(const unsigned int start, const unsigned int width) const {
+		/*
+		Returns bits [start, start+width) as an integer, with bit start as the least
+		significant bit. The field may straddle two words. width must be less than
+		64, and there is no bounds checking.
+		*/
+		unsigned int word = start / 64, offset = start % 64;
+		std::uint64_t bits = words[word] >> offset;
+		if(offset + width > 64) bits |= words[word+1] << (64 - offset);
+		return bits & ( (std::uint64_t(1) << width) - 1 );
+	} //field
+	
+	template<unsigned int B>
+	Chromosome<B>& Chromosome<B>::operator^=(const Chromosome& mask) {
+		for(unsigned int i=0; i<word_count; ++i) words[i] ^= mask.words[i];
+		return *this;
+	} //operator^=
+	
+	template<unsigned int B>
+	void Chromosome<B>::blend(const Chromosome& a, const Chromosome& b, const Chromosome& mask) {
+		/*
+		Takes each bit from a where mask is set and from b where it is not. This is
+		the kernel behind every crossover. It is safe for this to alias a or b.
+		*/
+		unsigned int i = 0;
+		std::uint64_t* out = words.data();
+		const std::uint64_t *pa = a.words.data(), *pb = b.words.data(), *pm = mask.words.data();
+#if defined(__AVX2__)
+		for(; i+4<=word_count; i+=4) {
+			__m256i va = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(pa+i) );
+			__m256i vb = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(pb+i) );
+			__m256i vm = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(pm+i) );
+			_mm256_storeu_si256( reinterpret_cast<__m256i*>(out+i), 
+					     _mm256_or_si256( _mm256_and_si256(va, vm), _mm256_andnot_si256(vm, vb) ) );
+		}
+#elif defined(__SSE2__)
+		for(; i+2<=word_count; i+=2) {
+			__m128i va = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pa+i) );
+			__m128i vb = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pb+i) );
+			__m128i vm = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pm+i) );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>(out+i), 
+					  _mm_or_si128( _mm_and_si128(va, vm), _mm_andnot_si128(vm, vb) ) );
+		}
+#endif
+		for(; i<word_count; ++i) out[i] = (pa[i] & pm[i]) | (pb[i] & ~pm[i]);
+	} //blend
+	
+	template<unsigned int B>
+	void Chromosome<B>::crossover(const Chromosome& a, const Chromosome& b, const unsigned int point) {
+		/*
+		Single-point crossover: bits [0, point] come from a and the rest from b.
+		Only the word containing the point needs a mask; the others are copied.
+		*/
+		unsigned int i, boundary = point / 64, shift = point % 64;
+		for(i=0; i<boundary; ++i) words[i] = a.words[i];
+		std::uint64_t mask = (shift == 63) ? ~std::uint64_t(0) : (std::uint64_t(1) << (shift+1)) - 1;
+		words[boundary] = (a.words[boundary] & mask) | (b.words[boundary] & ~mask);
+		for(i=boundary+1; i<word_count; ++i) words[i] = b.words[i];
+	} //crossover
+	
+	template<unsigned int B>
+	void Chromosome<B>::crossover(const Chromosome& a, const Chromosome& b, 
+				      const unsigned int* points, const unsigned int count) {
+		/*
+		Multi-point crossover: points must be ascending. Bits [0, points[0]] come
+		from a, (points[0], points[1]] from b, and so on, alternating. The segments 
+		are drawn into a mask a word at a time, then blended. 
+		*/
+		Chromosome mask;
+		unsigned int k, i, begin, end; //bit range [begin, end) taken from a
+		for(k=0; k<=count; k+=2) {
+			begin = (k == 0) ? 0 : points[k-1] + 1;
+			end = (k < count) ? points[k] + 1 : B;
+			if(begin >= end) continue;
+			
+			unsigned int first = begin / 64, last = (end - 1) / 64;
+			std::uint64_t low = ~std::uint64_t(0) << (begin % 64);
+			std::uint64_t high = ~std::uint64_t(0) >> (63 - (end - 1) % 64);
+			if(first == last) mask.words[first] |= low & high;
+			else {
+				mask.words[first] |= low;
+				for(i=first+1; i<last; ++i) mask.words[i] = ~std::uint64_t(0);
+				mask.words[last] |= high;
+			}
+		}
+		blend(a, b, mask);
+	} //crossover (multi-point)
+	
+	template<unsigned int B>
+	template<typename G>
+	void Chromosome<B>::crossover_uniform(const Chromosome& a, const Chromosome& b, G& generator) {
+		//uniform crossover: each bit comes from a or b with equal probability
+		Chromosome mask;
+		mask.randomize(generator);
+		blend(a, b, mask);
+	} //crossover_uniform
+	
+	template<unsigned int B>
+	template<typename G>
+	void Chromosome<B>::randomize(G& generator) {
+		//fills every bit at random, keeping the bits past B at zero
+		generator.generate(words.data(), word_count); //see Philox
+		words[word_count-1] &= last_word_mask();
+	} //randomize
+	
+	template<unsigned int B>
+	std::uint64_t Chromosome<B>::hash(const std::uint64_t seed) const {
+		/*
+		A 64-bit content hash, in the style of XXH64 but over whole words: four 
+		independent accumulators take every fourth word, so the multiplies of 
+		neighbouring words overlap (or share a SIMD register), and are merged and
+		mixed at the end. Equal Chromosomes always hash alike; different ones 
+		collide with probability about 2^-64. 
+		*/
+		const std::uint64_t prime1 = 0x9E3779B185EBCA87ull, prime2 = 0xC2B2AE3D27D4EB4Full;
+		auto rotl = [](const std::uint64_t x, const int k) { return (x << k) | (x >> (64 - k)); };
+		auto round = [&](std::uint64_t acc, const std::uint64_t word) { 
+			return rotl(acc + word*prime2, 31) * prime1; 
+		};
+		
+		std::array<std::uint64_t, 4> lanes = { {seed + prime1 + prime2, seed + prime2, 
+							seed, seed - prime1} };
+		unsigned int i, lane;
+		for(i=0; i+4<=word_count; i+=4) 
+			for(lane=0; lane<4; ++lane) lanes[lane] = round(lanes[lane], words[i+lane]);
+		
+		std::uint64_t h = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) 
+				  + rotl(lanes[3], 18);
+		for(lane=0; lane<4; ++lane) h = (h ^ round(0, lanes[lane])) * prime1 + prime2;
+		for(; i<word_count; ++i) h = rotl(h ^ round(0, words[i]), 27) * prime1 + prime2;
+		
+		h ^= B;
+		h = (h ^ (h >> 33)) * prime2;
+		h = (h ^ (h >> 29)) * 0x165667B19E3779F9ull;
+		return h ^ (h >> 32);
+	} //hash
+
+} //namespace john
+
@@ -0,0 +1,112 @@
+#ifndef Chromosome_h
+#define Chromosome_h
+
+/*
+    John: an evolutionary algorithm for genetic networks
+    Copyright (C) 2012  Jack Hall
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    e-mail: jackwhall7@gmail.com
+*/
+
+#include <array>
+#include <cstdint>
+#include <random>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace john {
+
+	//B is the number of bits
+	template<unsigned int B>
+	class Chromosome {
+	/*
+		A Chromosome is a fixed-length bit string, like std::bitset, except that 
+		its storage is exposed as 64-bit words so that decoding, crossover and 
+		mutation can work a whole word at a time. Bit i is bit i%64 of word i/64.
+		Bits past B in the last word are always zero.
+		
+		Crossover and mutation are masked word operations: a child is 
+		(a & mask) | (b & ~mask), and a mutation XORs in a mask of the bits to flip.
+		blend() uses AVX2 or SSE2 when the compiler targets them.
+	*/
+	public:
+		static const unsigned int word_count = (B + 63) / 64;
+		
+		class reference {
+		//proxy for a single bit, like std::bitset::reference
+		private:
+			std::uint64_t& word;
+			const std::uint64_t mask;
+			
+		public:
+			reference(std::uint64_t& rWord, const unsigned int bit) 
+				: word(rWord), mask(std::uint64_t(1) << bit) {}
+			reference& operator=(const bool value) { 
+				if(value) word |= mask; 
+				else word &= ~mask; 
+				return *this; 
+			}
+			reference& operator=(const reference& rhs) { return *this = bool(rhs); }
+			operator bool() const { return (word & mask) != 0; }
+			bool operator~() const { return (word & mask) == 0; }
+			reference& flip() { word ^= mask; return *this; }
+		}; //class reference
+		
+	private:
+		std::array<std::uint64_t, word_count> words;
+		
+	public:
+		Chromosome() : words() { words.fill(0); }
+		Chromosome(const Chromosome& rhs) = default;
+		Chromosome& operator=(const Chromosome& rhs) = default;
+		~Chromosome() = default;
+		
+		static constexpr unsigned int size() { return B; }
+		
+		bool operator[](const unsigned int i) const { return (words[i/64] >> (i%64)) & 1; }
+		reference operator[](const unsigned int i) { return reference(words[i/64], i%64); }
+		void flip(const unsigned int i) { words[i/64] ^= std::uint64_t(1) << (i%64); }
+		bool operator==(const Chromosome& rhs) const { return words == rhs.words; }
+		bool operator!=(const Chromosome& rhs) const { return words != rhs.words; }
+		std::uint64_t hash(const std::uint64_t seed=0) const; //of the contents
+		
+		std::uint64_t field(const unsigned int start, const unsigned int width) const;
+		
+		//crossover and mutation kernels, a word (or SIMD register) at a time
+		Chromosome& operator^=(const Chromosome& mask); //mutation: flips bits set in mask
+		void blend(const Chromosome& a, const Chromosome& b, const Chromosome& mask);
+		void crossover(const Chromosome& a, const Chromosome& b, const unsigned int point);
+		void crossover(const Chromosome& a, const Chromosome& b, 
+			       const unsigned int* points, const unsigned int count);
+		template<typename G>
+		void crossover_uniform(const Chromosome& a, const Chromosome& b, G& generator);
+		template<typename G>
+		void randomize(G& generator); //G needs a bulk generate(), like random_type
+		
+		//raw storage, for word-at-a-time algorithms; keep the bits past B at zero
+		std::uint64_t* data() { return words.data(); }
+		const std::uint64_t* data() const { return words.data(); }
+		static std::uint64_t last_word_mask() { 
+			return (B % 64 == 0) ? ~std::uint64_t(0) : (std::uint64_t(1) << (B % 64)) - 1; 
+		}
+		
+	}; //class Chromosome
+
+} //namespace john
+
+#endif
+
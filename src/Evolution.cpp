@@ -0,0 +1,97 @@
+/*
+    John: an evolutionary algorithm for genetic networks
+    Copyright (C) 2012  Jack Hall
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    e-mail: jackwhall7@gmail.com
+*/
+
+namespace john {
+
+	template<unsigned int N, unsigned int I, unsigned int O>
+	Evolution<N,I,O>::Evolution(const unsigned int nSize, evaluation_type fEvaluate, 
+				    const std::uint64_t nSeed, const unsigned int nWorkers)
+		: fitness(nSeed), genomes(), pool(nWorkers), evaluate(fEvaluate), 
+		  cache(2*nSize), reuse_values(false), population(nSize, NULL), 
+		  children(nSize, NULL), parents(nSize), next_ID(nSize) {
+		//create and evaluate a random first generation with IDs [0, nSize)
+		genomes.reserve(2*nSize); //room for two generations
+		for(auto& genome : population) genome = static_cast< Genotype<N,I,O>* >( genomes.allocate() );
+		
+		fitness.defer( pool.size() );
+		pool.parallel_for(0, nSize, [&](const std::size_t i) {
+			express( *new(population[i]) Genotype<N,I,O>(i, &fitness, &genomes) );
+		});
+		fitness.commit();
+	} //constructor
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	Evolution<N,I,O>::~Evolution() {
+		fitness.defer( pool.size() );
+		destroy_all(population);
+		fitness.commit();
+	} //destructor
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	void Evolution<N,I,O>::express(Genotype<N,I,O>& genome) {
+		//called on many threads at once; the cache has its own locks
+		real_type value;
+		if( !(reuse_values && cache.find_value(genome.hash(), value)) ) {
+			Phenotype<N,I,O> phenotype(genome, cache.decode(genome));
+			value = evaluate(phenotype);
+			cache.set_value(genome.hash(), value);
+		}
+		genome.set_value(value);
+	} //express
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	void Evolution<N,I,O>::destroy_all(std::vector< Genotype<N,I,O>* >& generation) {
+		//destroy in parallel, then give the slots back in order
+		pool.parallel_for(0, generation.size(), [&](const std::size_t i) { 
+			generation[i]->~Genotype(); 
+		});
+		for(auto& genome : generation) {
+			genomes.deallocate(genome);
+			genome = NULL;
+		}
+	} //destroy_all
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	void Evolution<N,I,O>::step() {
+		//select parents for the whole generation in one pass
+		unsigned int size = population.size();
+		if(size < 2) return; //no pair of parents to breed from
+		fitness.breed(parents.data(), size);
+		fitness.next_generation();
+		
+		//take slots for the children from the pool, on this thread
+		for(auto& genome : children) genome = static_cast< Genotype<N,I,O>* >( genomes.allocate() );
+		
+		//breed, decode and evaluate children on every worker
+		ID_type first_ID = next_ID;
+		next_ID += size;
+		fitness.defer( pool.size() );
+		pool.parallel_for(0, size, [&](const std::size_t i) {
+			express( *new(children[i]) Genotype<N,I,O>(first_ID + i, parents[i]) );
+		});
+		
+		//the old generation dies once every child has been bred
+		destroy_all(population);
+		fitness.commit();
+		population.swap(children);
+	} //step
+
+} //namespace john
+
@@ -0,0 +1,98 @@
+#ifndef Evolution_h
+#define Evolution_h
+
+/*
+    John: an evolutionary algorithm for genetic networks
+    Copyright (C) 2012  Jack Hall
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    e-mail: jackwhall7@gmail.com
+*/
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace john {
+
+	template<unsigned int N, unsigned int I, unsigned int O>
+	class Evolution {
+	/*
+		An Evolution object drives a whole population through generations. Each
+		call to step() replaces the population: parents are chosen for every child 
+		in one pass (the batch Fitness::breed), then each child is bred, decoded 
+		into a Phenotype and evaluated on the ThreadPool, and finally the old 
+		generation is destroyed, also in parallel. Fitness is deferred during the 
+		parallel phases, so registrations are merged once per generation. 
+		Genotypes live in a GenomePool; the slots for a generation are taken 
+		before the parallel phase, and the constructor reserves slots for two 
+		generations, so no step allocates memory for Genotypes themselves. Each 
+		child's genome table, and the chunks it does not share with its 
+		parents, come from the GenomePool's BlockPools, which stop growing once 
+		the number of live genomes levels off. 
+		
+		Children get consecutive IDs, and all of their random streams are keyed 
+		by (seed, generation, ID, purpose), so a run gives the same population for
+		the same seed on any number of threads. The evaluation function is called
+		concurrently and must be thread-safe; its return value becomes the child's
+		value. 
+		
+		A GenomeCache of twice the population size lets children identical to a 
+		recent genome share its decoded Phenotype parameters. With 
+		set_value_reuse(true), such children also take the cached value instead 
+		of being evaluated at all. That is only right if the evaluation depends on
+		nothing but the genome (not, for example, on the Phenotype's random 
+		stream, which is keyed by ID), and then results are still independent of 
+		the number of threads. 
+	*/
+	public:
+		typedef std::function<real_type(Phenotype<N,I,O>&)> evaluation_type;
+		
+	private:
+		Fitness<N,I,O> fitness; //declared first, so it outlives the population
+		GenomePool<N,I,O> genomes;
+		ThreadPool pool;
+		evaluation_type evaluate;
+		GenomeCache<N,I,O> cache;
+		bool reuse_values;
+		std::vector< Genotype<N,I,O>* > population, children; //in slots of genomes
+		std::vector< std::pair< Genotype<N,I,O>*, Genotype<N,I,O>* > > parents; //of each child
+		ID_type next_ID;
+		
+		void express(Genotype<N,I,O>& genome); //decode, evaluate and set value
+		void destroy_all(std::vector< Genotype<N,I,O>* >& generation);
+		
+	public:
+		Evolution(const unsigned int nSize, evaluation_type fEvaluate, 
+			  const std::uint64_t nSeed=0, const unsigned int nWorkers=0);
+		Evolution(const Evolution& rhs) = delete;
+		Evolution& operator=(const Evolution& rhs) = delete;
+		~Evolution();
+		
+		void step(); //does nothing for a population of fewer than two
+		void set_value_reuse(const bool bReuse) { reuse_values = bReuse; }
+		bool is_value_reuse() const { return reuse_values; }
+		
+		unsigned int size() const { return population.size(); }
+		std::uint32_t generation() const { return fitness.generation(); }
+		const Genotype<N,I,O>& operator[](const unsigned int i) const { return *population[i]; }
+		
+	}; //class Evolution
+
+} //namespace john
+
+#endif
+
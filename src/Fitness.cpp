@@ -20,81 +20,278 @@
 
 namespace john {
 	
+	template<unsigned int N, unsigned int I, unsigned int O> 
+	Fitness<N,I,O>::Fitness(const std::uint64_t nSeed) 
+		: population(), members(), free_slots(), weights(), seed_val(nSeed), 
+		  generation_val(0), generator(nSeed, 0, 0, Purpose::select), 
+		  pending(), deferred(false) {}
+	
+	template<unsigned int N, unsigned int I, unsigned int O> 
+	void Fitness<N,I,O>::next_generation() {
+		//Genotypes created from now on draw from the new generation's streams
+		++generation_val;
+		generator = random_type(seed_val, generation_val, 0, Purpose::select);
+	} //next_generation
+	
 	template<unsigned int N, unsigned int I, unsigned int O> 
 	std::pair< Genotype<N,I,O>*, Genotype<N,I,O>* > Fitness<N,I,O>::breed() {
 		/*
-		This method chooses two genotypes to breed based on their Node values. 
-		The values must be polled from each Genotype. If Node values are not 
-		positive, this will not work.
+		This method chooses two genotypes to breed based on their values. Values
+		are read from the SumTree kept up to date by add, remove and revalue, so
+		nothing has to be polled here. Negative values are treated as zero. The 
+		father is drawn with the mother's weight masked out, so the parents always 
+		differ without any retrying. Returns a pair of NULLs if there are fewer 
+		than two Genotypes.
 		*/
-		//poll genotypes for value and compute the total value
-		vector<real_type> values( population.size(), 0.0 );
-		real_type total=0.0;
-		auto itv = values.begin();
-		auto it = population.begin();
-		auto ite = population.end();
-		while(it != ite) {
-			*itv = it->second->value;
-			total += *itv;
-			++it; ++itv;
-		}
+		std::pair< Genotype<N,I,O>*, Genotype<N,I,O>* > parents(NULL, NULL);
+		if(population.size() < 2) return parents;
 		
-		//probabilistically select two genotypes by their pointers
-		Genotype<N,I,O>* mother( select(value, total) );
-		Genotype<N,I,O>* father( select(value, total) );
-		while(mother == father) father = select(value,total); //ensure parents differ
-		std::pair< Genotype<N,I,O>*, Genotype<N,I,O>* > parents(mother, father);
+		unsigned int mother = select();
+		unsigned int father = select_excluding(mother);
+		parents.first = members[mother];
+		parents.second = members[father];
 		return parents;
 	} //breed
 	
-	template<unsigned int N, unsigned int I, unsigned int O>
-	Genotype<N,I,O>* Fitness<N,I,O>::select(const vector<real_type>& values, 
-						const real_type total) {
+	template<unsigned int N, unsigned int I, unsigned int O> 
+	void Fitness<N,I,O>::breed(std::pair< Genotype<N,I,O>*, Genotype<N,I,O>* >* parents, 
+				   const unsigned int count) {
 		/*
-		This method iterates through the population, selecting one genotype
-		using a random number. The random number is scaled between 0 and the 
-		total population value, which corresponds to the total fitness.
+		Fills parents[0..count) with pairs chosen from a single snapshot of the 
+		population values, using stochastic universal sampling: 2*count evenly 
+		spaced pointers with one random offset are matched against the running 
+		total of the values in one walk over the slots. The picks are shuffled 
+		into pairs, and pairs whose parents coincide swap fathers with another 
+		pair (or, failing that, draw a new father with select_excluding). The 
+		whole call is O(n + count). If every value is zero, each Genotype gets 
+		equal weight. With fewer than two Genotypes, the pairs are NULL. 
 		*/
-		real_type choice = total * std::generate_canonical<float, 15>(generator);
+		unsigned int k, j, tries, slot, n = members.size(), picks_size = 2*count;
+		if(population.size() < 2) {
+			for(k=0; k<count; ++k) parents[k] = std::make_pair(nullptr, nullptr);
+			return;
+		}
+		if(count == 0) return;
+		
+		//snapshot weights; if they are all zero, weigh each Genotype equally
+		const double* values = weights.data();
+		bool uniform = weights.total() <= 0.0;
+		auto weight = [&](const unsigned int s) -> double {
+			if(uniform) return (members[s] != NULL) ? 1.0 : 0.0;
+			else return values[s];
+		};
+		double total = 0.0;
+		for(slot=0; slot<n; ++slot) total += weight(slot);
+		
+		//one pass over the slots places all 2*count evenly spaced pointers
+		std::vector<unsigned int> picks(picks_size);
+		double spacing = total / picks_size;
+		double pointer = spacing * std::generate_canonical<double, 32>(generator);
+		double cumulative = weight(0);
+		slot = 0;
+		for(k=0; k<picks_size; ++k, pointer += spacing) {
+			while(cumulative <= pointer && slot < n-1) cumulative += weight(++slot);
+			if(members[slot] == NULL || weight(slot) <= 0.0) picks[k] = select(); //rounding
+			else picks[k] = slot;
+		}
+		
+		//picks come out sorted by slot, so shuffle them before pairing
+		for(k=picks_size-1; k>0; --k) {
+			j = std::uniform_int_distribution<unsigned int>(0, k)(generator);
+			std::swap(picks[k], picks[j]);
+		}
 		
-		auto it = values.begin();
-		auto ite = values.end();
-		auto itm = population.begin();
-		while(it != ite) {
-			choice -= *it;
-			if(choice < 0) break; //this one
-			++it; ++itm;
+		//make sure every mother differs from her father
+		std::uniform_int_distribution<unsigned int> random_pair(0, count-1);
+		for(k=0; k<count; ++k) {
+			unsigned int& mother = picks[2*k];
+			unsigned int& father = picks[2*k+1];
+			for(tries=0; mother==father && tries<4; ++tries) {
+				j = random_pair(generator);
+				if(picks[2*j] != father && picks[2*j+1] != mother) 
+					std::swap(father, picks[2*j+1]);
+			}
+			if(mother == father) father = select_excluding(mother); //dominant Genotype
 		}
-		return itm->second; //should be valid if choice is between zero and one
+		
+		for(k=0; k<count; ++k) 
+			parents[k] = std::make_pair(members[picks[2*k]], members[picks[2*k+1]]);
+	} //breed (batch)
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	unsigned int Fitness<N,I,O>::select() {
+		/*
+		Selects one slot with probability proportional to its value, in O(log n).
+		If every value is zero (a new population, for example), the choice is 
+		uniform instead. 
+		*/
+		double total = weights.total();
+		if(total <= 0.0) return select_uniform( members.size() );
+		
+		unsigned int slot = weights.find( total * std::generate_canonical<double, 32>(generator) );
+		if(members[slot] == NULL || weights.get(slot) <= 0.0) 
+			return select_uniform( members.size() ); //only reachable through rounding
+		return slot;
 	} //select
 	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	unsigned int Fitness<N,I,O>::select_excluding(const unsigned int excluded) {
+		/*
+		Same as select, but the excluded slot has its weight temporarily set to 
+		zero, so it cannot be chosen. 
+		*/
+		double excluded_weight = weights.get(excluded);
+		weights.set(excluded, 0.0);
+		
+		unsigned int slot;
+		double total = weights.total();
+		if(total <= 0.0) slot = select_uniform(excluded);
+		else {
+			slot = weights.find( total * std::generate_canonical<double, 32>(generator) );
+			if(members[slot] == NULL || weights.get(slot) <= 0.0) 
+				slot = select_uniform(excluded);
+		}
+		
+		weights.set(excluded, excluded_weight);
+		return slot;
+	} //select_excluding
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	unsigned int Fitness<N,I,O>::select_uniform(const unsigned int excluded) {
+		/*
+		Fallback for when no slot has positive weight: starts at a random slot and
+		walks forward to the first occupied one other than excluded. This is O(n),
+		but only happens while the whole population is valued at zero. 
+		*/
+		unsigned int n = members.size();
+		std::uniform_int_distribution<unsigned int> random_slot(0, n-1);
+		unsigned int slot = random_slot(generator);
+		for(unsigned int i=0; i<n; ++i, ++slot) {
+			if(slot == n) slot = 0;
+			if(members[slot] != NULL && slot != excluded) return slot;
+		}
+		return excluded; //only if excluded is the sole occupant
+	} //select_uniform
+	
 	template<unsigned int N, unsigned int I, unsigned int O> 
 	bool Fitness<N,I,O>::add(const ID_type address, Genotype<N,I,O>* new_genome) {
 		/*
-		Adds new Genotype and ID to the population. The map::insert method checks
-		to see whether that ID is already being used, and rejects the new value if
-		an old value exists. It also returns whether the new ID was added. 
+		Adds new Genotype and ID to the population. If that ID is already being 
+		used, the new Genotype is rejected and this returns false. Slots freed by
+		remove are reused; otherwise the slot arrays double in size, so the O(n) 
+		SumTree rebuild is amortized away. 
+		In deferred mode, the Genotype is only queued, and this returns true.
 		*/
-		pair< ID_type, Genotype<N,I,O>* > element;
-		auto result = population.insert( std::make_pair(address, new_genome) );
-		return result->second; //whether element was inserted
+		if(deferred) {
+			Registration registration = {address, new_genome, new_genome->get_value()};
+			pending[ ThreadPool::worker_index() ].adds.push_back(registration);
+			return true;
+		}
+		if(population.find(address) != SlotIndex::npos) return false;
+		
+		if( free_slots.empty() ) {
+			unsigned int old_size = members.size();
+			unsigned int new_size = (old_size == 0) ? 1 : 2*old_size;
+			members.resize(new_size, NULL);
+			weights.resize(new_size);
+			for(unsigned int i=new_size; i>old_size; --i) free_slots.push_back(i-1);
+		}
+		
+		unsigned int slot = free_slots.back();
+		free_slots.pop_back();
+		population.insert(address, slot);
+		members[slot] = new_genome;
+		weights.set( slot, new_genome->get_value() );
+		return true;
 	} //add
 	
 	template<unsigned int N, unsigned int I, unsigned int O> 
 	void Fitness<N,I,O>::remove(const ID_type address) {
-		population.erase(address); //does nothing if address is invalid
+		if(deferred) { pending[ ThreadPool::worker_index() ].removes.push_back(address); return; }
+		
+		unsigned int slot = population.erase(address);
+		if(slot == SlotIndex::npos) return; //does nothing if address is invalid
+		
+		weights.set(slot, 0.0);
+		members[slot] = NULL;
+		free_slots.push_back(slot);
 	} //remove
 	
 	template<unsigned int N, unsigned int I, unsigned int O> 
-	bool Fitness<N,I,O>::update(const ID_type address, Genotype<N>* pGenotype) {
+	bool Fitness<N,I,O>::update(const ID_type address, Genotype<N,I,O>* pGenotype) {
 		/*
 		Updates the pointer to an existing Genotype. Returns false if the address
 		is invalid.
 		*/
-		auto it = population.find(address);
-		if(it != population.end()) { it->second = pGenotype; return true; }
+		unsigned int slot = population.find(address);
+		if(slot != SlotIndex::npos) { members[slot] = pGenotype; return true; }
 		else return false; //whether element existed in the first place
 	} //update
 	
+	template<unsigned int N, unsigned int I, unsigned int O> 
+	bool Fitness<N,I,O>::revalue(const ID_type address, const real_type new_value) {
+		/*
+		Records a new value for an existing Genotype, in O(log n). Returns false 
+		if the address is invalid (in deferred mode, this is only known on commit).
+		*/
+		if(deferred) {
+			Registration registration = {address, NULL, new_value};
+			pending[ ThreadPool::worker_index() ].revalues.push_back(registration);
+			return true;
+		}
+		unsigned int slot = population.find(address);
+		if(slot != SlotIndex::npos) { weights.set(slot, new_value); return true; }
+		else return false;
+	} //revalue
+	
+	template<unsigned int N, unsigned int I, unsigned int O> 
+	void Fitness<N,I,O>::defer(const unsigned int workers) {
+		//one buffer per ThreadPool worker (see ThreadPool::size)
+		pending.assign( workers, Pending() );
+		deferred = true;
+	} //defer
+	
+	template<unsigned int N, unsigned int I, unsigned int O> 
+	void Fitness<N,I,O>::commit() {
+		/*
+		Merges the per-worker buffers and applies them, each kind sorted by ID so 
+		that slots are handed out the same way whatever thread did the work. 
+		Nothing is applied while deferred, so the population is still as it was 
+		at defer(). An ID both added and removed that was not in it then is a 
+		Genotype made and destroyed while deferred, which never enters the 
+		population. An ID that was in it is a member replaced by a new Genotype 
+		with the same ID, so the remove and the add both apply. Removals go 
+		first, so that their slots can be reused by the additions.
+		*/
+		deferred = false;
+		std::vector<Registration> adds, revalues;
+		std::vector<ID_type> removes;
+		for(Pending& buffer : pending) {
+			adds.insert( adds.end(), buffer.adds.begin(), buffer.adds.end() );
+			revalues.insert( revalues.end(), buffer.revalues.begin(), buffer.revalues.end() );
+			removes.insert( removes.end(), buffer.removes.begin(), buffer.removes.end() );
+		}
+		pending.clear();
+		std::sort( adds.begin(), adds.end() );
+		std::stable_sort( revalues.begin(), revalues.end() ); //keeps each worker's order
+		std::sort( removes.begin(), removes.end() );
+		
+		//IDs both added and removed, that were not members before defer()
+		std::vector<ID_type> transient;
+		for(Registration& registration : adds) 
+			if( std::binary_search(removes.begin(), removes.end(), registration.ID) 
+			    && population.find(registration.ID) == SlotIndex::npos ) 
+				transient.push_back(registration.ID);
+		
+		for(ID_type address : removes) 
+			if( !std::binary_search(transient.begin(), transient.end(), address) ) 
+				remove(address);
+		for(Registration& registration : adds) 
+			if( !std::binary_search(transient.begin(), transient.end(), registration.ID) ) 
+				add(registration.ID, registration.genome);
+		for(Registration& registration : revalues) 
+			revalue(registration.ID, registration.value);
+	} //commit
+	
 } //namespace john
 
@@ -21,8 +21,11 @@
     e-mail: jackwhall7@gmail.com
 */
 
-#include <map>
 #include <vector>
+#include <random>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
 
 namespace john {
 
@@ -33,27 +36,78 @@ namespace john {
 		population. Its main function is to decide which two existing Genotypes 
 		will serve as parents for a new Genotype. This decision is made with
 		probabilities weighted by the value of each Genotype. 
+		
+		The population is stored by slot, as parallel arrays: the Genotype of each
+		slot in members, and its value in a SumTree, whose raw weights are one 
+		contiguous array. A SlotIndex maps IDs to slots, and freed slots are 
+		recycled, so add and remove allocate nothing once the arrays are big 
+		enough. A selection costs O(log n) instead of a pass over the whole 
+		population. Genotypes must report value changes through revalue() 
+		(Genotype::set_value does this) for the selection weights to stay current.
+		To replace a whole generation, the batch version of breed() draws all the 
+		parent pairs from one snapshot of the values in a single O(n + K) pass.
+		
+		Fitness also holds the run's seed and the current generation. Together with
+		an ID and a Purpose, these name the random stream of every Genotype and 
+		Phenotype, so a run is reproducible no matter which thread builds what.
+		Selection draws from the stream (seed, generation, 0, Purpose::select).
+		
+		Between defer() and commit(), add, remove and revalue only append to a 
+		buffer for the calling ThreadPool worker, so Genotypes can be built and 
+		destroyed on many threads at once. commit() applies the buffers in order 
+		of ID, so the result does not depend on the number of threads. Nothing 
+		else may be called while deferred. 
 	*/
 	private:
-		map<unsigned int, Genotype<N,I,O>*> population;
-		std::minstd_rand generator; //for choosing individuals for breeding
+		SlotIndex population; //ID -> slot
+		std::vector< Genotype<N,I,O>* > members; //slot -> Genotype, NULL if free
+		std::vector<unsigned int> free_slots;
+		SumTree<double> weights; //slot -> value, double to limit rounding drift
+		std::uint64_t seed_val; //names every random stream of the run
+		std::uint32_t generation_val;
+		random_type generator; //for choosing individuals for breeding
 		
-		Genotype<N,I,O>* select(vector<real_type> values, real_type total);
+		//registrations made while deferred, one buffer per ThreadPool worker
+		struct Registration {
+			ID_type ID;
+			Genotype<N,I,O>* genome;
+			real_type value;
+			bool operator<(const Registration& rhs) const { return ID < rhs.ID; }
+		};
+		struct Pending {
+			std::vector<Registration> adds, revalues;
+			std::vector<ID_type> removes;
+		};
+		std::vector<Pending> pending;
+		bool deferred;
+		
+		unsigned int select();
+		unsigned int select_excluding(const unsigned int excluded);
+		unsigned int select_uniform(const unsigned int excluded);
 		
 	public:
-		Fitness() = default;
+		explicit Fitness(const std::uint64_t nSeed=0);
 		Fitness(const Fitness& rhs) = delete;
 		//Fitness(Fitness&& rhs);
 		Fitness& operator=(const Fitness& rhs) = delete;
 		//Fitness& operator=(Fitness&& rhs);
 		~Fitness() = default;
 		
-		unsigned int population_size() { return population.size(); }
+		unsigned int population_size() const { return population.size(); }
+		std::uint64_t seed() const { return seed_val; }
+		std::uint32_t generation() const { return generation_val; }
+		void next_generation();
 		
-		std::pair< Genotype<N,I,O>*, Genotype<N,I,O>* > breed() const;
-		void add(const ID_type address, Genotype<N>* new_genome);
+		std::pair< Genotype<N,I,O>*, Genotype<N,I,O>* > breed();
+		void breed(std::pair< Genotype<N,I,O>*, Genotype<N,I,O>* >* parents, 
+			   const unsigned int count);
+		bool add(const ID_type address, Genotype<N,I,O>* new_genome);
 		void remove(const ID_type address);
-		void update(const ID_type address, Genotype<N>* pGenotype);
+		bool update(const ID_type address, Genotype<N,I,O>* pGenotype);
+		bool revalue(const ID_type address, const real_type new_value);
+		
+		void defer(const unsigned int workers);
+		void commit();
 		
 	}; //class Fitness
 
@@ -0,0 +1,113 @@
+/*
+    John: an evolutionary algorithm for genetic networks
+    Copyright (C) 2012  Jack Hall
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    e-mail: jackwhall7@gmail.com
+*/
+
+namespace john {
+
+	template<unsigned int N, unsigned int I, unsigned int O>
+	GenomeCache<N,I,O>::GenomeCache(const unsigned int nCapacity, const unsigned int nShards) 
+		: decoded_blocks(), shards(), shard_bits(0), set_bits(0) {
+		//round both up to powers of two, so shard and set come straight from bits
+		while( (1u << shard_bits) < nShards ) ++shard_bits;
+		while( (std::size_t(ways) << set_bits << shard_bits) < nCapacity ) ++set_bits;
+		
+		shards.reset( new Shard[1u << shard_bits] );
+		for(unsigned int s=0; s<(1u << shard_bits); ++s) {
+			shards[s].clock = 0;
+			shards[s].entries.assign( ways << set_bits, Entry() );
+			for(Entry& entry : shards[s].entries) entry.stamp = 0;
+		}
+	} //constructor
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	typename GenomeCache<N,I,O>::Entry* 
+	GenomeCache<N,I,O>::find(Shard& shard, const std::uint64_t hash) const {
+		//the set is picked by the low bits, which the shard choice did not use
+		Entry* set = &shard.entries[ (hash & ((1u << set_bits) - 1)) * ways ];
+		for(unsigned int w=0; w<ways; ++w) {
+			if(set[w].stamp != 0 && set[w].hash == hash) {
+				set[w].stamp = ++shard.clock;
+				return &set[w];
+			}
+		}
+		return NULL;
+	} //find
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	typename GenomeCache<N,I,O>::Entry& 
+	GenomeCache<N,I,O>::claim(Shard& shard, const std::uint64_t hash) const {
+		//returns the entry of hash, emptying the least recently used one if absent
+		Entry* entry = find(shard, hash);
+		if(entry != NULL) return *entry;
+		
+		Entry* set = &shard.entries[ (hash & ((1u << set_bits) - 1)) * ways ];
+		entry = &set[0];
+		for(unsigned int w=1; w<ways; ++w) 
+			if(set[w].stamp < entry->stamp) entry = &set[w];
+		entry->hash = hash;
+		entry->stamp = ++shard.clock;
+		entry->decoded.reset();
+		entry->valued = false;
+		return *entry;
+	} //claim
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	std::shared_ptr<const typename Phenotype<N,I,O>::Decoded> 
+	GenomeCache<N,I,O>::decode(const Genotype<N,I,O>& genome) {
+		/*
+		Decoding happens outside the lock, so other threads are not held up. If 
+		two threads decode the same new genome at once, the second to finish 
+		adopts the first one's result, and the extra copy is released. 
+		*/
+		Shard& shard = shard_of( genome.hash() );
+		{
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			Entry* entry = find(shard, genome.hash());
+			if(entry != NULL && entry->decoded) return entry->decoded;
+		}
+		
+		std::shared_ptr<const decoded_type> decoded = Phenotype<N,I,O>::decode(genome, &decoded_blocks);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		Entry& entry = claim(shard, genome.hash());
+		if(!entry.decoded) entry.decoded = decoded;
+		return entry.decoded;
+	} //decode
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	bool GenomeCache<N,I,O>::find_value(const std::uint64_t hash, real_type& value) {
+		//returns whether a value is known for hash, and if so, copies it to value
+		Shard& shard = shard_of(hash);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		Entry* entry = find(shard, hash);
+		if(entry == NULL || !entry->valued) return false;
+		value = entry->value;
+		return true;
+	} //find_value
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	void GenomeCache<N,I,O>::set_value(const std::uint64_t hash, const real_type value) {
+		Shard& shard = shard_of(hash);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		Entry& entry = claim(shard, hash);
+		entry.value = value;
+		entry.valued = true;
+	} //set_value
+
+} //namespace john
+
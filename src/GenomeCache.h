@@ -0,0 +1,103 @@
+#ifndef GenomeCache_h
+#define GenomeCache_h
+
+/*
+    John: an evolutionary algorithm for genetic networks
+    Copyright (C) 2012  Jack Hall
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    e-mail: jackwhall7@gmail.com
+*/
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace john {
+
+	template<unsigned int N, unsigned int I, unsigned int O>
+	class GenomeCache {
+	/*
+		A GenomeCache remembers recent genomes by their content hash 
+		(Genotype::hash), so that identical offspring, which crossover and small
+		mutations produce often, do not each pay for decoding and evaluation. For 
+		each hash it keeps the decoded Phenotype parameters, shared by reference 
+		count between every Phenotype built from them, and the last value reported
+		for that genome. 
+		
+		The cache is bounded and safe to use from many threads. Entries live in 
+		shards, each with its own mutex, chosen by the top bits of the hash. Within
+		a shard, the cache is 4-way set associative: a hash can only occupy the 4 
+		entries of one set, and a new hash replaces the least recently used of 
+		them, so there is no allocation and no list to maintain. Evicting an entry
+		never invalidates Phenotypes still holding its decoded parameters. 
+		
+		Decoded parameters are allocated from the cache's own BlockPool, and go 
+		back to it when the last Phenotype or entry holding them lets go, so once
+		the cache is full, decoding does no heap allocation. Phenotypes built 
+		from them must therefore not outlive the cache. 
+		
+		Two genomes are taken to be identical if their 64-bit hashes are. Among a 
+		million cached genomes, the chance of any collision is below 1 in 10^7.
+	*/
+	public:
+		typedef typename Phenotype<N,I,O>::Decoded decoded_type;
+		static const unsigned int ways = 4; //entries per set
+		
+	private:
+		struct Entry {
+			std::uint64_t hash;
+			std::uint64_t stamp; //time of last use within the shard, 0 if empty
+			std::shared_ptr<const decoded_type> decoded; //may be empty
+			real_type value;
+			bool valued; //whether value was reported
+		};
+		struct Shard {
+			std::mutex mutex;
+			std::uint64_t clock; //advances on every use
+			std::vector<Entry> entries; //sets of ways entries
+		};
+		
+		BlockPool decoded_blocks; //declared first, so it outlives the entries
+		std::unique_ptr<Shard[]> shards;
+		unsigned int shard_bits, set_bits; //log2 of shards, and of sets per shard
+		
+		Shard& shard_of(const std::uint64_t hash) const { 
+			return shards[ shard_bits == 0 ? 0 : hash >> (64 - shard_bits) ]; 
+		}
+		Entry* find(Shard& shard, const std::uint64_t hash) const; //NULL if absent
+		Entry& claim(Shard& shard, const std::uint64_t hash) const; //find or evict
+		
+	public:
+		explicit GenomeCache(const unsigned int nCapacity, const unsigned int nShards=16);
+		GenomeCache(const GenomeCache& rhs) = delete;
+		GenomeCache& operator=(const GenomeCache& rhs) = delete;
+		~GenomeCache() = default;
+		
+		std::size_t capacity() const { return (std::size_t(ways) << set_bits) << shard_bits; }
+		
+		//decoded parameters of genome, decoding and caching them if necessary
+		std::shared_ptr<const typename Phenotype<N,I,O>::Decoded> 
+			decode(const Genotype<N,I,O>& genome);
+		bool find_value(const std::uint64_t hash, real_type& value);
+		void set_value(const std::uint64_t hash, const real_type value);
+		
+	}; //class GenomeCache
+
+} //namespace john
+
+#endif
+
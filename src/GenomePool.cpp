@@ -0,0 +1,55 @@
+/*
+    John: an evolutionary algorithm for genetic networks
+    Copyright (C) 2012  Jack Hall
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    e-mail: jackwhall7@gmail.com
+*/
+
+namespace john {
+
+	template<unsigned int N, unsigned int I, unsigned int O>
+	constexpr std::size_t GenomePool<N,I,O>::slab_size;
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	void GenomePool<N,I,O>::grow() {
+		//slots are pushed in reverse, so a new slab is handed out front to back
+		slabs.emplace_back( new slot_type[slab_size] );
+		free_slots.reserve( capacity() ); //room for every slot, so deallocate never grows it
+		slot_type* slab = slabs.back().get();
+		for(std::size_t i=slab_size; i>0; --i) free_slots.push_back(slab + i - 1);
+	} //grow
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	void GenomePool<N,I,O>::reserve(const std::size_t count) {
+		//makes sure count more Genotypes can be allocated without a new slab
+		while(free_slots.size() < count) grow();
+	} //reserve
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	void* GenomePool<N,I,O>::allocate() {
+		if( free_slots.empty() ) grow();
+		void* slot = free_slots.back();
+		free_slots.pop_back();
+		return slot;
+	} //allocate
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	void GenomePool<N,I,O>::deallocate(void* slot) {
+		free_slots.push_back(slot);
+	} //deallocate
+
+} //namespace john
+
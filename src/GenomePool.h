@@ -0,0 +1,96 @@
+#ifndef GenomePool_h
+#define GenomePool_h
+
+/*
+    John: an evolutionary algorithm for genetic networks
+    Copyright (C) 2012  Jack Hall
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    e-mail: jackwhall7@gmail.com
+*/
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <cstddef>
+
+namespace john {
+
+	template<unsigned int N, unsigned int I, unsigned int O>
+	class GenomePool {
+	/*
+		A GenomePool owns the memory of a population's Genotypes. Memory comes in 
+		slabs of slab_size Genotypes, sized from N, I and O so that a slab is about
+		64 KiB, and is never given back until the pool is destroyed. A Genotype's 
+		slot goes back on a free list when it dies, and the next Genotype is built
+		in place in the most recently freed slot, which is likely still in cache.
+		Once a population has reached its size, breeding does no heap allocation, 
+		and the chromosomes of a generation sit next to each other in a few slabs.
+		The pool also owns the BlockPools that the genomes of its Genotypes take 
+		their tables and chunks from (see Genotype), which are thread-safe. 
+		
+		allocate and deallocate are not thread-safe, but constructing and 
+		destroying Genotypes in slots that are already allocated is; Evolution 
+		takes all the slots for a generation before it breeds on many threads.
+		The pool does not track which slots are in use, so every Genotype must be
+		destroyed (and its slot given back) before the pool goes away. 
+	*/
+	public:
+		typedef Genotype<N,I,O> genome_type;
+		static constexpr std::size_t slab_size = 
+			(sizeof(genome_type) >= (1u << 16)) ? 1 : (1u << 16) / sizeof(genome_type);
+		
+	private:
+		typedef typename std::aligned_storage<sizeof(genome_type), 
+						      alignof(genome_type)>::type slot_type;
+		std::vector< std::unique_ptr<slot_type[]> > slabs;
+		std::vector<void*> free_slots; //most recently freed last
+		BlockPool chunk_blocks, table_blocks; //for SharedChromosome chunks and tables
+		
+		void grow();
+		
+	public:
+		GenomePool() = default;
+		GenomePool(const GenomePool& rhs) = delete;
+		GenomePool& operator=(const GenomePool& rhs) = delete;
+		~GenomePool() = default;
+		
+		std::size_t capacity() const { return slabs.size() * slab_size; }
+		std::size_t available() const { return free_slots.size(); }
+		void reserve(const std::size_t count);
+		
+		void* allocate(); //raw slot for one Genotype, to be built with placement new
+		void deallocate(void* slot); //slot of a Genotype that was already destroyed
+		BlockPool& chunks() { return chunk_blocks; }
+		BlockPool& tables() { return table_blocks; }
+		
+		template<typename... Args>
+		genome_type* create(Args&&... args) {
+			void* slot = allocate();
+			return new(slot) genome_type( std::forward<Args>(args)... );
+		} //create
+		
+		void destroy(genome_type* genome) {
+			genome->~genome_type();
+			deallocate(genome);
+		} //destroy
+		
+	}; //class GenomePool
+
+} //namespace john
+
+#endif
+
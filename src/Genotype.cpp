@@ -21,112 +21,188 @@
 namespace john {
 
 	template<unsigned int N, unsigned int I, unsigned int O>
-	Genotype::Genotype(const ID_type nID, 
-			   Fitness<N,I,O>* pFitness) 
-		: ID(nID), fitness(pFitness), value(0.0), generator(nID),
-		  link_chromosome(), decision_chromosome() {
+	Genotype<N,I,O>::Genotype(const ID_type nID, 
+			   Fitness<N,I,O>* pFitness, 
+			   GenomePool<N,I,O>* pPool) 
+		: fitness(pFitness), pool(pPool), value(0.0), 
+		  generator(pFitness->seed(), pFitness->generation(), nID, Purpose::initialize),
+		  genome(), delta(), ID(nID) {
 		  
 		fitness->add(ID, this);
+		std::shared_ptr<genome_type> built = make_genome();
 		
-		//create random bit-string for decision_chromosome
-		std::bernoulli_distribution random_bit(0.5);
-		for(int i=decision_chromosome.size()-1; i>=0; --i) {
-			decision_chromosome[i] = random_bit(generator);
-		}
+		//create random bit-string for decision chromosome, whole words at a time
+		Chromosome<decision_bits> decisions;
+		decisions.randomize(generator);
+		for(unsigned int w=0; w<Chromosome<decision_bits>::word_count; ++w) 
+			built->assign(64*w, 64, decisions.data()[w]);
 		
-		//create an array of random bitsets, each of which contains two ones
-		int x, y;
-		std::uniform_int_distribution<> random_int(0, link_chromosome[0].size() - 1);
-		for(i=link_chromosome.size()-1; i>=0; --i) {
-			x = random_int(generator);
-			y = random_int(generator);
-			while(x == y) y = random_int(generator);
+		//create a random pair of distinct source indices for each gene from a 
+		//single draw: each 32-bit half is scaled to its range by a multiplication,
+		//and the second index skips over the first rather than being redrawn
+		std::uint64_t bits;
+		unsigned int x, y, i;
+		link_type links;
+		for(i=0; i<N*N; ++i) {
+			bits = generator();
+			x = ( (bits & 0xFFFFFFFF) * (N*N+N) ) >> 32; //[0, N*N+N)
+			y = ( (bits >> 32) * (N*N+N-1) ) >> 32; //[0, N*N+N-1)
+			if(y >= x) ++y;
 			
-			link_chromosome[i][x] = true;
-			link_chromosome[i][y] = true;
+			links[0] = x;
+			links[1] = y;
+			sort_links(links);
+			built->assign(link_offset + i*link_bits, link_bits, pack(links));
 		}
+		
+		built->finish();
+		genome = built; //so materialize() has nothing to do
 	} //constructor
 	
 	template<unsigned int N, unsigned int I, unsigned int O>
-	Genotype::Genotype(const ID_type nID, const std::pair<Genotype*, Genotype*> parents) 
-		: ID(nID), decision_chromosome(), link_chromosome(),
-		  fitness(parents.first->fitness), value(0.0), generator(nID) {
+	Genotype<N,I,O>::Genotype(const ID_type nID, const std::pair<Genotype*, Genotype*> parents) 
+		: fitness(parents.first->fitness), pool(parents.first->pool), value(0.0), 
+		  generator(fitness->seed(), fitness->generation(), nID, Purpose::breed),
+		  genome(), delta(), ID(nID) {
 		
 		real_type mutation_rate = 0.2, crossover_rate = 0.5;
-		int i, j, ii, jj;
 		
 		//breed new chromosomes from parents, use hardcoded mutation and crossover rates
 		fitness->add(ID, this);
 		
+		//nothing is copied here: the child records how it differs from its 
+		//parents, and build() applies that when the child is first read
+		parents.first->materialize();
+		parents.second->materialize();
+		delta.first = parents.first->genome;
+		delta.second = parents.second->genome;
+		//without crossover, all of each chromosome comes from the first parent
+		delta.points = {{link_offset - 1, link_offset - 1, genome_type::padded_size - 1}};
+		delta.flip = decision_bits;
+		delta.link_gene = N*N;
+		
 		//what does crossover rate mean?
-		//generate 2 random numbers for decision_chromosome crossover
-		std::uniform_int_distribution<> random_int(0, decision_chromosome.size() - 1);
+		//generate a random crossover point for decision chromosome
+		std::uniform_int_distribution<> random_int(0, decision_bits - 1);
 		std::bernoulli_distribution crossover(crossover_rate);
 		if( crossover(generator) ) {
-			i = random_int(generator);
-			
-			//take beginning of chromosome from first parent ...
-			for(ii=i; ii>=0; --ii) 
-				decision_chromosome[ii] = parents.first->decision_chromosome[ii];
-			
-			//... and the rest from the second parent
-			for(ii=decision_chromosome.size()-1; ii>i; --ii) 
-				decision_chromosome[ii] = parents.second->decision_chromosome[ii];
+			//take beginning of chromosome from first parent and the rest from the second
+			delta.points[0] = random_int(generator);
 		}
 		
 		//decide whether to mutate
 		std::bernoulli_distribution mutate(mutation_rate);
-		random_int = std::uniform_int_distribution<>(0, decision_chromosome.size() - 1);
-		if( mutate(generator) ) ~decision_chromosome[random_int(generator)]; //flip a bit
+		if( mutate(generator) ) delta.flip = random_int(generator); //flip a bit
 		
-		//generate 2 random numbers for link_chromosome crossover
+		//generate a random crossover point for link chromosome
+		random_int = std::uniform_int_distribution<>(0, N*N - 1);
 		if( crossover(generator) ) {
-			ii = random_int(generator);
-			
-			//take beginning of chromosome from first parent ...
-			for(i=i; i>=0; --i) //over genetic nodes
-				for(j=link_chromosome[0].size()-1; j>=0; --j) //over each connectivity vector
-					link_chromosome[i][j] = parents.first->link_chromosome[i][j];
-			
-			//... and the rest from the second parent
-			for(i=decision_chromosome.size()-1; i>ii; --i) 
-				for(j=link_chromosome[0].size()-1; j>=0; --j)
-					link_chromosome[i][j] = parents.second->link_chromosome[i][j];
+			//take genes [0, point] from first parent and the rest from the second
+			delta.points[2] = link_offset + (random_int(generator) + 1)*link_bits - 1;
 		}
 		
 		//decide whether to mutate
-		//mutations must occur in pairs to preserve K=2 connectivity
-		random_int = std::uniform_int_distribution<>(0, link_chromosome.size() - 1);
-		i = random_int(generator); //which bitset
-		
-		random_int = std::uniform_int_distribution<>(0, link_chromosome[0].size() - 1);
-		j = random_int(generator); //which false bit to flip
-		
-		std::bernoulli_distribution random_bit(0.5);
-		bool first = random_bit(generator); //which true bit to flip (there are only 2)
-		
-		ii = link_chromosome[0].size() - 1;
+		//mutations move one of a gene's two links, to preserve K=2 connectivity
 		if( mutate(generator) ) {
-			for(ii; ii>=0; --ii) {
-				if( link_chromosome[i][ii] ) { //true bit found
-					if(first) { link_chromosome[i][ii] = false; break; }
-					else first = true; //flip next true bit
-				} 
-			} 
+			delta.link_gene = random_int(generator); //which gene
+			bool from_first = link_offset + delta.link_gene*link_bits <= delta.points[2];
+			link_type& links = delta.links;
+			links = (from_first ? parents.first : parents.second)->links(delta.link_gene);
+			
+			std::bernoulli_distribution random_bit(0.5);
+			bool first = random_bit(generator); //which link to move (there are only 2)
+			
+			//draw a new source other than the two current ones, without retrying:
+			//skip over the current sources (links[1] < links[0]) as they are passed
+			std::uniform_int_distribution<> random_source(0, N*N+N - 3);
+			unsigned int source = random_source(generator);
+			if(source >= links[1]) ++source;
+			if(source >= links[0]) ++source;
 			
-			while(link_chromosome[i][j]) { //make sure bit is false to start with
-				j = random_int(generator);
-			} 
-			//may reflip the same bit, but it doesn't matter; happens rarely
-			link_chromosome[i][j] = true;
+			if(first) links[0] = source;
+			else links[1] = source;
+			sort_links(links);
 		} //if
-		
 	} //constructor
 	
 	template<unsigned int N, unsigned int I, unsigned int O>
-	Genotype::~Genotype() {
+	Genotype<N,I,O>::~Genotype() {
 		fitness->remove(ID);
 	} //destructor
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	void Genotype<N,I,O>::set_value(const real_type new_value) {
+		value = new_value;
+		fitness->revalue(ID, value); //keep selection weights current
+	} //set_value
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	void Genotype<N,I,O>::sort_links(link_type& links) {
+		/*
+		Keeps the larger source index first. Phenotype reads the first link as the 
+		more significant truth table input, and this is the order the one-hot form 
+		always implied (it was scanned from the highest index down). 
+		*/
+		if(links[0] < links[1]) std::swap(links[0], links[1]);
+	} //sort_links
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	std::uint64_t Genotype<N,I,O>::pack(const link_type& links) {
+		return links[0] | std::uint64_t(links[1]) << (link_bits / 2);
+	} //pack
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	typename Genotype<N,I,O>::link_type Genotype<N,I,O>::links(const unsigned int gene) const {
+		std::uint64_t bits = contents().field(link_offset + gene*link_bits, link_bits);
+		link_type result;
+		result[0] = bits & ( (std::uint64_t(1) << (link_bits / 2)) - 1 );
+		result[1] = bits >> (link_bits / 2);
+		return result;
+	} //links
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	void Genotype<N,I,O>::build() const {
+		/*
+		Materializes a bred Genotype: crossover shares every chunk of the parents'
+		genomes that lies within one segment, mutation copies the (at most two) 
+		chunks it writes to, and the references to the parents are dropped. Runs 
+		once, under materialized; random Genotypes are complete from the start.
+		*/
+		if(genome) return;
+		std::shared_ptr<genome_type> built = make_genome( 
+			*delta.first, *delta.second, delta.points.data(), delta.points.size() );
+		if(delta.flip < decision_bits) built->flip(delta.flip);
+		if(delta.link_gene < N*N) 
+			built->assign(link_offset + delta.link_gene*link_bits, link_bits, pack(delta.links));
+		built->finish();
+		
+		genome = built;
+		delta.first.reset();
+		delta.second.reset();
+	} //build
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	template<typename... Args>
+	std::shared_ptr<typename Genotype<N,I,O>::genome_type> 
+	Genotype<N,I,O>::make_genome(Args&&... args) const {
+		//a genome_type built from args, with its table and chunks from pool
+		if(pool == NULL) 
+			return std::make_shared<genome_type>( std::forward<Args>(args)..., 
+							      static_cast<BlockPool*>(NULL) );
+		return std::allocate_shared<genome_type>( PoolAllocator<genome_type>(&pool->tables()), 
+							  std::forward<Args>(args)..., &pool->chunks() );
+	} //make_genome
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	std::array< std::bitset<N*N + N>, N*N > Genotype<N,I,O>::one_hot_links() const {
+		std::array< std::bitset<N*N + N>, N*N > rows;
+		for(unsigned int i=0; i<N*N; ++i) {
+			link_type gene_links = links(i);
+			rows[i][ gene_links[0] ] = true;
+			rows[i][ gene_links[1] ] = true;
+		}
+		return rows;
+	} //one_hot_links
 
 } //namespace john
 
@@ -21,13 +21,25 @@
     e-mail: jackwhall7@gmail.com
 */
 
+#include <algorithm>
 #include <array>
 #include <bitset>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <utility>
 
 namespace john {
 
 	template<unsigned int N, unsigned int I, unsigned int O>
 	class Fitness;
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	class GenomePool;
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	class Phenotype;
 
 	//N is # of attractors (sqrt of # of nodes)
 	//I is # of non-boolean inputs to gene network
@@ -42,31 +54,88 @@ namespace john {
 		and the second constructor performs crossover and mutation from two parents. The
 		Phenotype class has private access in order to parse the genome. 
 		
+		The value is private so that every change goes through set_value, which 
+		keeps the selection weights in Fitness current. 
+		
+		The link chromosome stores the two source indices of each gene directly
+		(2-4 bytes per gene) rather than as one-hot rows of N*N+N bits, which grew 
+		as O(N^4). one_hot_links() still produces the one-hot form for export.
+		
+		Both chromosomes are stored together in one SharedChromosome: the decision
+		bits first, then the links, each starting on a chunk boundary so that the 
+		two crossovers never share a chunk. A bred Genotype at first stores only a
+		delta: references to its parents' genomes, the crossover points and the 
+		mutations. It is materialized the first time it is read (for decoding, 
+		hashing or breeding), and then shares every chunk that crossover and 
+		mutation left untouched with its parents. The delta holds its parents' 
+		genomes by reference count, so parents may die first. Materializing is 
+		thread-safe. Given a GenomePool, a Genotype takes its genome's table and 
+		chunks from the pool's BlockPools, and its children do the same, so 
+		breeding does no heap allocation once the pools have grown; without 
+		one, they come from the heap. 
+		
+		A Genotype never changes after construction, so it has a hash of its 
+		contents. Links are always sorted, and unused bits are always zero, so 
+		identical genomes hash alike however they arose. 
+		
 	*/
 	private:
-		Fitness<N>* fitness;
+		Fitness<N,I,O>* fitness;
+		GenomePool<N,I,O>* pool; //for genome memory, NULL for the heap
+		real_type value;
 		//17 bit numbers, K=2 connectivity
-		std::bitset< //only need one chromosome now
-		std::bitset<N*N*2*2 + (I+O+1)*17*N> decision_chromosome;
-		std::array< std::bitset<N*N + N>, N*N > link_chromosome;
+		static const unsigned int decision_bits = N*N*2*2 + (I+O+1)*17*N;
+		//two source indices (into Phenotype state) per gene, larger one first
+		typedef std::array<typename gene_index<N>::type, 2> link_type;
+		static const unsigned int link_bits = 8*sizeof(link_type); //per gene
+		static const unsigned int link_offset = SharedChromosome<decision_bits>::padded_size;
+		typedef SharedChromosome<link_offset + N*N*link_bits> genome_type;
 		//mutation and crossover rates? probably just hardcode these for now
 		
-		std::minstd_rand generator;
+		struct Delta {
+			std::shared_ptr<const genome_type> first, second; //until materialized
+			std::array<unsigned int, 3> points; //crossover points, for genome_type
+			unsigned int flip; //decision bit to flip, decision_bits if none
+			unsigned int link_gene; //gene whose link moved, N*N if none
+			link_type links; //new links of link_gene
+		};
+		
+		random_type generator; //stream (seed, generation, ID, purpose)
+		mutable std::shared_ptr<const genome_type> genome; //empty until materialized
+		mutable Delta delta;
+		mutable std::once_flag materialized;
+		
+		static void sort_links(link_type& links);
+		static std::uint64_t pack(const link_type& links);
+		void materialize() const { std::call_once(materialized, &Genotype::build, this); }
+		void build() const; //from delta
+		const genome_type& contents() const { materialize(); return *genome; }
+		link_type links(const unsigned int gene) const;
+		template<typename... Args>
+		std::shared_ptr<genome_type> make_genome(Args&&... args) const; //from pool
 		
 	public:
 		const ID_type ID;
-		real_type value;
 		
 		Genotype() = delete;
 		Genotype(const ID_type nID,  
-			 Fitness<N,I,O>* pFitness);
-		Genotype(const ID_type nID, const Genotype& mother, const Genotype& father);
+			 Fitness<N,I,O>* pFitness, 
+			 GenomePool<N,I,O>* pPool=NULL);
+		Genotype(const ID_type nID, const std::pair<Genotype*, Genotype*> parents);
 		Genotype(const Genotype& rhs) = delete;
 		//Genotype(Genotype&& rhs); 
 		Genotype& operator=(const Genotype& rhs) = delete;
 		//Genotype& operator=(Genotype&& rhs);
 		~Genotype();
 		
+		real_type get_value() const { return value; }
+		void set_value(const real_type new_value);
+		//equal for Genotypes with identical chromosomes (see GenomeCache)
+		std::uint64_t hash() const { return contents().hash(); }
+		
+		//the links in their original form, one row per gene with two bits set
+		std::array< std::bitset<N*N + N>, N*N > one_hot_links() const;
+		
 		friend class Phenotype<N,I,O>; //only Phenotype constructor actually needs access
 		
 	}; //class Genotype
@@ -21,19 +21,76 @@
     e-mail: jackwhall7@gmail.com
 */
 
+#include <cstdint>
+#include <type_traits>
+
 namespace john {
 
 	typedef float real_type;
 	typedef unsigned int ID_type;
+	
+	//Phenotype outputs use a fast, vectorizable sigmoid (within about 1.2e-7, or 
+	//2 ulp, of the precise one); define JOHN_PRECISE_SIGMOID to use the double 
+	//precision exp instead, for validation
+	
+	//decoded Phenotype parameters, and the sums of their products with inputs;
+	//define JOHN_FIXED_POINT to store them as 16-bit fixed point (see Phenotype)
+#ifdef JOHN_FIXED_POINT
+	typedef std::int16_t parameter_type; //Q8.7, every decoded value to within 1/256
+	typedef std::int32_t sum_type; //exact
+	const unsigned int fraction_bits = 7;
+#else
+	typedef real_type parameter_type;
+	typedef real_type sum_type;
+#endif
+	
+	//random number generator used throughout; Xoshiro256 also fits here
+	class Philox;
+	typedef Philox random_type;
+	
+	//what a random stream is for; one of the four words that name a stream
+	enum class Purpose : std::uint32_t { initialize, breed, select, express };
+	
+	//smallest unsigned integer that can index the N*N+N states of a gene network
+	template<unsigned int N>
+	struct gene_index {
+		typedef typename std::conditional<(N*N+N <= 256), 
+						  std::uint8_t, std::uint16_t>::type type;
+	};
 
 } //namespace john
 
+#include "Xoshiro256.h"
+#include "Philox.h"
+#include "ThreadPool.h"
+#include "BlockPool.h"
+#include "SlotIndex.h"
+#include "SumTree.h"
+#include "Chromosome.h"
+#include "SharedChromosome.h"
 #include "Genotype.h"
+#include "GenomePool.h"
 #include "Fitness.h"
 #include "Phenotype.h"
+#include "PhenotypeSlice.h"
+#include "PhenotypeBatch.h"
+#include "GenomeCache.h"
+#include "Evolution.h"
+#include "BitNode.h"
+#include "BitTree.h"
+#include "SumTree.cpp"
+#include "Chromosome.cpp"
+#include "SharedChromosome.cpp"
 #include "Fitness.cpp"
 #include "Genotype.cpp"
+#include "GenomePool.cpp"
 #include "Phenotype.cpp"
+#include "PhenotypeSlice.cpp"
+#include "PhenotypeBatch.cpp"
+#include "GenomeCache.cpp"
+#include "Evolution.cpp"
+//ThreadPool.cpp, BlockPool.cpp, BitNode.cpp and BitTree.cpp are not templates, 
+//so they are compiled on their own
 
 #endif
 
@@ -21,176 +21,468 @@
 namespace john {
 
 	template<unsigned int N, unsigned int I, unsigned int O>
-	Phenotype<N,I,O>::Phenotype(Genotype<N,I,O>& genome) {	
-
-		int n = N*N*2*2 + (I+O+1)*17*N;
+	Phenotype<N,I,O>::Phenotype(Genotype<N,I,O>& genome) 
+		: Phenotype(genome, decode(genome)) {}
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	Phenotype<N,I,O>::Phenotype(Genotype<N,I,O>& genome, std::shared_ptr<const Decoded> nDecoded) 
+		: decoded(std::move(nDecoded)), 
+		  generator(genome.fitness->seed(), genome.fitness->generation(), 
+			    genome.ID, Purpose::express) {
+		incremental = false;
+		sweep_needed = true;
+		changes_size = 0;
+		
+		memo_head = 0;
+		memo_size = 0;
+		cycle_length = 0;
+	} //constructor
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	std::shared_ptr<const typename Phenotype<N,I,O>::Decoded> 
+	Phenotype<N,I,O>::decode(const Genotype<N,I,O>& genome, BlockPool* pool) {
+		/*
+		Decodes the genome by reading the decision chromosome in fields of whole
+		words rather than bit by bit. Truth tables are 4-bit fields, and each real
+		number is a 17-bit field that indexes a precomputed table of every value 
+		get_parameter can produce. 
+		*/
+		std::shared_ptr<Decoded> result = (pool == NULL) ? std::make_shared<Decoded>() 
+			: std::allocate_shared<Decoded>( PoolAllocator<Decoded>(pool) );
+		auto& program = result->program; //shorthand
+		auto& input_decisions = result->input_decisions;
+		auto& output_weights = result->output_weights;
+		const typename Genotype<N,I,O>::genome_type& sequence = genome.contents();
+		unsigned int i = 0; //current index in decision chromosome
 		
 		//extract boolean functions (4 bits each)
-		auto itf = functions.begin(); //iterators over genetic nodes (25)
-		auto itfe = functions.end();
-		int i = 0; //current index in decision_chromosome
-		int j; //temporary loop counter, reused
+		auto itf = program.begin(); //iterators over genetic nodes (25)
+		auto itfe = program.end();
 		while(itf != itfe) {
-			//grab four bits and store them in the proper bitset
-			for(j=3; j>=0; --j, ++i) (*itf)[j] = genome.decision_chromosome[i];
-			++itf;
+			//the first of the four bits is the most significant in the truth table
+			itf->table = reverse_nibble( sequence.field(i, 4) );
+			++itf; i+=4;
 		}
 		
 		//extract input decision boundaries
 		auto iti = input_decisions.begin(); //iterators for boolean genetic inputs (5)
 		auto itie = input_decisions.end();
-		array<real_type, I+1>::iterator it, ite; //iterators for inner arrays
 		while(iti != itie) {
-			//get iterators for inner array (one set of boundary parameters)
-			it = iti->begin();
-			ite = iti->end();
-			
 			//extract a float for each inner array element
-			while(it != ite) {
-				*it = get_real<n>(genome.decision_chromosome, i);
-				++it; i+=17;
+			for(parameter_type& boundary : *iti) {
+				boundary = get_parameter( sequence.field(i, 17) );
+				i+=17;
 			}
 			++iti;
 		}
 		
-		//extract output weights
-		auto ito = output_weights.begin(); //iterators for real outputs (7)
-		auto itoe = output_weights.end();
-		array<real_type, N>::iterator iter, itere; //iterators for inner arrays
-		while(ito != itoe) {
-			//get iterators for inner array (one set of output weights)
-			iter = ito->begin();
-			itere = ito->end();
-			
-			//extract a float for each inner array element
-			while(iter != itere) {
-				*iter = get_real<n>(genome.decision_chromosome, i);
-				++iter; i+=17;
+		//extract output weights, one output after another, into columns
+		for(unsigned int output=0; output<O; ++output) {
+			for(auto& gene : output_weights) {
+				gene[output] = get_parameter( sequence.field(i, 17) );
+				i+=17;
 			}
-			++ito;
 		}
 		
 		//extract gene connectivity
-		auto itl = genome.link_chromosome.begin();
-		auto itc = links.begin();
-		auto itce = links.end();
-		while(itc != itce) {
-			j = 0; //no links recorded for current genetic node
-			for(i=itl->size()-1; i>=0; --i) {
-				if( (*itl)[i] ) { 
-					(*itc)[j] = i; //record index of origin genetic node
-					++j; //increment link counter
+		for(i=0; i<N*N; ++i) {
+			typename Genotype<N,I,O>::link_type links = genome.links(i);
+			program[i].source[0] = links[0];
+			program[i].source[1] = links[1];
+		}
+		
+		find_live_genes(*result);
+		build_fanout(*result);
+		return result;
+	} //decode
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	void Phenotype<N,I,O>::find_live_genes(Decoded& decoded) {
+		/*
+		Walks the links backwards from the output-facing genes (the last N) to 
+		find every gene whose state can eventually reach an output. Outputs only 
+		ever read those genes, so run() can skip the rest without changing any 
+		result. Evolved K=2 networks often leave many genes dead.
+		*/
+		const auto& program = decoded.program; //shorthand
+		auto& live = decoded.live;
+		unsigned int& live_size = decoded.live_size;
+		std::bitset<N*N+N> reached; //indices into state
+		std::array<unsigned int, N*N+N> stack;
+		unsigned int top = 0, s, j;
+		for(j=0; j<N; ++j) {
+			reached[N*N+j] = true;
+			stack[top++] = N*N+j;
+		}
+		
+		while(top > 0) {
+			s = stack[--top];
+			if(s < N) continue; //network input, no links
+			for(j=0; j<2; ++j) {
+				unsigned int source = program[s-N].source[j];
+				if( !reached[source] ) {
+					reached[source] = true;
+					stack[top++] = source;
 				}
-				if(j == 2) break; //if both links are found, stop looking
 			}
-			++itc; ++itl;
 		}
 		
-	} //constructor
+		//keep ascending gene order so run() still streams through program
+		live_size = 0;
+		for(j=0; j<N*N; ++j) 
+			if( reached[N+j] ) live[live_size++] = j;
+	} //find_live_genes
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	void Phenotype<N,I,O>::build_fanout(Decoded& decoded) {
+		/*
+		Inverts the links of the live genes into a compressed adjacency list: the 
+		genes reading state s are fanout[fanout_begin[s]] up to (not including)
+		fanout[fanout_begin[s+1]]. A gene reading the same source twice is listed
+		twice, which step_changes tolerates. 
+		*/
+		const auto& program = decoded.program; //shorthand
+		const auto& live = decoded.live;
+		const unsigned int live_size = decoded.live_size;
+		auto& fanout_begin = decoded.fanout_begin;
+		auto& fanout = decoded.fanout;
+		unsigned int k, j, s;
+		fanout_begin.fill(0);
+		for(k=0; k<live_size; ++k) 
+			for(j=0; j<2; ++j) ++fanout_begin[ program[ live[k] ].source[j] + 1 ];
+		for(s=0; s<N*N+N; ++s) fanout_begin[s+1] += fanout_begin[s];
+		
+		std::array<unsigned int, N*N+N> next; //next free position for each source
+		for(s=0; s<N*N+N; ++s) next[s] = fanout_begin[s];
+		for(k=0; k<live_size; ++k) 
+			for(j=0; j<2; ++j) fanout[ next[ program[ live[k] ].source[j] ]++ ] = live[k];
+	} //build_fanout
 
 	template<unsigned int N, unsigned int I, unsigned int O>
-	real_type Phenotype<N,I,O>::get_real(std::bitset<N*N*2*2 + (I+O+1)*17*N>& sequence, 
-					     const unsigned int start) const {
+	parameter_type Phenotype<N,I,O>::get_parameter(const std::uint64_t field) {
 		/*
-		Extracts a floating point number from a bit sequence. The number is encoded
+		Extracts a floating point number from a 17-bit field. The number is encoded
 		with a sign and two integers, as shown below. This coding is compact and keeps
 		numbers from getting unreasonably small or large. It should improve the 
 		evolutionary fitness surface over normal floating point numbers. 
+		
+		Since there are only 2^17 possible fields, every value is computed once 
+		into a table, indexed by the raw field: bit 0 is the sign, bits 1-8 and 
+		9-16 are the two 8-bit integers in Gray's code (least significant first).
+		The table holds parameter_type, so in fixed point it is half the size.
 		*/
-		if(sequence[start]) sign = 1.0;
-		else sign = -1.0;
-		a = get_integer(sequence, start+1); 
-		b = get_integer(sequence, start+9); //8-bit integers
-		return sign*a/(1.0 + b); 
-	} //get_real
-
+		static const std::vector<parameter_type> table = build_parameter_table();
+		return table[field];
+	} //get_parameter
+	
 	template<unsigned int N, unsigned int I, unsigned int O>
-	unsigned long Phenotype<N,I,O>::get_integer(std::bitset<N*N*2*2 + (I+O+1)*17*N>& sequence, 
-						    unsigned int start) const {
-		/*
-		Translates an 8-bit portion of a bit sequence to an integer. The integers are
-		coded in the genome with Gray's coding, which hopefully improves the fitness
-		surface by smoothing it out. This method may segfault if the sequence isn't long
-		enough (there is no bounds checking).
-		*/
-		std::bitset<8> integer;
-		unsigned int i=start, j=0;
-		for(i, j; i<(start+8); ++i, ++j) integer[j] = sequence[i];
-		return gray_to_binary( integer.to_ulong() );
-	} //get_integer
+	std::vector<parameter_type> Phenotype<N,I,O>::build_parameter_table() {
+		std::vector<parameter_type> table(1 << 17);
+		real_type sign;
+		unsigned long a, b;
+		for(std::uint64_t field=0; field<table.size(); ++field) {
+			if(field & 1) sign = 1.0;
+			else sign = -1.0;
+			a = gray_to_binary( (field >> 1) & 0xFF ); 
+			b = gray_to_binary( (field >> 9) & 0xFF ); //8-bit integers
+			table[field] = to_parameter( sign*a/(1.0 + b) ); 
+		}
+		return table;
+	} //build_parameter_table
 	
 	template<unsigned int N, unsigned int I, unsigned int O>
-	unsigned long Phenotype<N,I,O>::gray_to_binary(unsigned long num) const {
-		/*
-		Translates a binary number in Gray's code to the same number in base 2. Got
-		this from the internet, so I hope it works. 
-		*/
-		unsigned int numBits = 8 * sizeof(num);
-		unsigned int shift;
-	    	for (shift = 1; shift < numBits; shift *= 2) {
-			num ^= num >> shift;
-	    	}
-	    	return num;
-	} //gray_to_binary
+	parameter_type Phenotype<N,I,O>::to_parameter(const real_type x) {
+	#ifdef JOHN_FIXED_POINT
+		return static_cast<parameter_type>( std::lround( x * unit() ) ); //|x| <= 255
+	#else
+		return x;
+	#endif
+	} //to_parameter
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	parameter_type Phenotype<N,I,O>::to_input(const real_type x) {
+	#ifdef JOHN_FIXED_POINT
+		//|input| < 2^14 keeps the three products and bias of a boundary below 2^31
+		real_type scaled = std::min( std::max(x * unit(), -16383.0f), 16383.0f );
+		return static_cast<parameter_type>( std::lround(scaled) );
+	#else
+		return x;
+	#endif
+	} //to_input
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	real_type Phenotype<N,I,O>::from_sum(const sum_type sum) {
+	#ifdef JOHN_FIXED_POINT
+		return sum * (real_type(1) / unit()); //exact, while |sum| < 2^24
+	#else
+		return sum;
+	#endif
+	} //from_sum
 	
 	template<unsigned int N, unsigned int I, unsigned int O>
 	void Phenotype<N,I,O>::run(const real_type value, const real_type dvalue, const real_type persistence) {
 		//unroll loops with template metaprogramming?
 	
 		//run decision boundaries on inputs
-		std::array< std::array<real_type, I+1>, N >& w = input_decisions; //shorthand
+		const std::array<parameter_type, I> x = { {to_input(value), to_input(dvalue), 
+							   to_input(persistence)} };
+		std::bitset<N> inputs;
 		int i;
-		for(i=(N-1); i>=0; --i) 
-			state[i] = ( w[i][0]*value + w[i][1]*dvalue 
-				    +w[i][2]*persistence + w[i][3] ) > 0;
+		for(i=(N-1); i>=0; --i) inputs[i] = decide_input(i, x);
 		
-		//evaluate boolean network (update state)
-		bitset<N*N> new_state;
-		for(i=(N*N-1); i>=0; --i) 
-			new_state[i] = gene_fcn( i, state[ links[i][0] ], state[ links[i][1] ] );
+		//while the inputs hold still, a network in an attractor just replays it
+		if(inputs == memo_inputs) {
+			if(cycle_length > 0) {
+				cycle_phase = (cycle_phase + 1) % cycle_length;
+				recall( (cycle_start + cycle_phase) % memo_capacity );
+				return;
+			}
+		} else {
+			forget_attractor();
+			memo_inputs = inputs;
+		}
+		for(i=(N-1); i>=0; --i) {
+			if(incremental && state[i] != inputs[i]) changes[changes_size++] = i;
+			state[i] = inputs[i];
+		}
 		
-		for(i=(N*N-1), i>=0; --i) state[i+N] = new_state[i];
+		//evaluate boolean network (update state)
+		bool outputs_changed = true;
+		if(incremental && !sweep_needed) outputs_changed = step_changes();
+		else step_all();
 
-		//calculate and store current output values
-		std::array< std::array<real_type, N>, O >& v = output_weights; //shorthand
-		std::array<real_type, O> outputs;
-		for(i=(O-1); i>=0; --i) { 
-			//calculate values from v and states
-			outputs[i] = 0.0;
-			for(int j=(N-1); j>=0; --j) outputs[i] += v[i][j] * state[N*N+j];
+		if(outputs_changed) update_outputs(); //otherwise they are already current
+		remember();
+	} //run
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	void Phenotype<N,I,O>::step_all() {
+		//evaluate every live gene; in incremental mode, also record which ones flip
+		const auto& program = decoded->program; //shorthand
+		const auto& live = decoded->live;
+		const unsigned int live_size = decoded->live_size;
+		std::bitset<N*N> new_state;
+		unsigned int k;
+		for(k=0; k<live_size; ++k) {
+			const Gene<N>& gene = program[ live[k] ];
+			new_state[ live[k] ] = gene_fcn( gene, state[ gene.source[0] ], 
+							 state[ gene.source[1] ] );
+		}
+		
+		changes_size = 0;
+		for(k=0; k<live_size; ++k) {
+			if(incremental && state[ live[k]+N ] != new_state[ live[k] ])
+				changes[changes_size++] = live[k] + N;
+			state[ live[k]+N ] = new_state[ live[k] ];
+		}
+		sweep_needed = false;
+	} //step_all
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	bool Phenotype<N,I,O>::step_changes() {
+		/*
+		Event-driven version of step_all. A gene can only change if one of its 
+		sources changed since it was last evaluated, so only the fan-out of the 
+		states listed in changes (genes flipped by the last step, plus inputs 
+		flipped by this one) is evaluated. Returns whether any output-facing gene
+		flipped, since otherwise the outputs need no recalculation. 
+		*/
+		const Decoded& d = *decoded; //shorthand
+		unsigned int k, f, gene_index, dirty_size = 0;
+		for(k=0; k<changes_size; ++k) {
+			for(f=d.fanout_begin[ changes[k] ]; f<d.fanout_begin[ changes[k]+1 ]; ++f) {
+				gene_index = d.fanout[f];
+				if( !dirty[gene_index] ) {
+					dirty[gene_index] = true;
+					dirty_genes[dirty_size++] = gene_index;
+				}
+			}
+		}
+		
+		std::bitset<N*N> new_state;
+		for(k=0; k<dirty_size; ++k) {
+			const Gene<N>& gene = d.program[ dirty_genes[k] ];
+			new_state[ dirty_genes[k] ] = gene_fcn( gene, state[ gene.source[0] ], 
+								state[ gene.source[1] ] );
+		}
+		
+		bool outputs_changed = false;
+		changes_size = 0;
+		for(k=0; k<dirty_size; ++k) {
+			gene_index = dirty_genes[k];
+			dirty[gene_index] = false;
+			if(state[gene_index+N] != new_state[gene_index]) {
+				state[gene_index+N] = new_state[gene_index];
+				changes[changes_size++] = gene_index + N;
+				if(gene_index >= N*N-N) outputs_changed = true;
+			}
+		}
+		return outputs_changed;
+	} //step_changes
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	void Phenotype<N,I,O>::set_incremental(const bool bIncremental) {
+		//the first step in incremental mode is a full sweep, to establish changes
+		incremental = bIncremental;
+		sweep_needed = true;
+		changes_size = 0;
+	} //set_incremental
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	void Phenotype<N,I,O>::remember() {
+		/*
+		Compares the state after a step with the recorded states, newest first.
+		A match k+1 steps back means the network has entered a cycle of length k+1
+		(a fixed point if k=0), made of the recorded steps from the match onward. 
+		Otherwise the state and its outputs are recorded, overwriting the oldest.
+		*/
+		std::size_t hash = std::hash< std::bitset<N*N+N> >()(state);
+		unsigned int k, entry;
+		for(k=0; k<memo_size; ++k) {
+			entry = (memo_head + memo_capacity - 1 - k) % memo_capacity;
+			if(memo[entry].hash == hash && memo[entry].state == state) {
+				cycle_start = entry;
+				cycle_length = k + 1;
+				cycle_phase = 0; //state is the same as memo[cycle_start].state
+				return;
+			}
+		}
+		
+		Step& step = memo[memo_head];
+		step.hash = hash;
+		step.state = state;
+		step.outputs = { {learning_rate_val, momentum_val, weight_decay_val, forget_factor_val,
+				  kill_link_prob, make_link_prob, make_node_prob} };
+		memo_head = (memo_head + 1) % memo_capacity;
+		if(memo_size < memo_capacity) ++memo_size;
+	} //remember
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	void Phenotype<N,I,O>::recall(const unsigned int entry) {
+		const std::array<real_type, O>& outputs = memo[entry].outputs; //shorthand
+		learning_rate_val = outputs[0];
+		momentum_val 	  = outputs[1];
+		weight_decay_val  = outputs[2];
+		forget_factor_val = outputs[3];
+		kill_link_prob	  = outputs[4];
+		make_link_prob 	  = outputs[5];
+		make_node_prob	  = outputs[6];
+	} //recall
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	void Phenotype<N,I,O>::forget_attractor() {
+		/*
+		Empties the record of recent states. Must be called whenever state is
+		changed other than by run(). If a cycle was being replayed, state is first
+		set to the current step of the cycle. 
+		*/
+		if(cycle_length > 0) {
+			state = memo[ (cycle_start + cycle_phase) % memo_capacity ].state;
+			sweep_needed = true; //changes no longer describe the last step
+		}
+		memo_size = 0;
+		cycle_length = 0;
+	} //forget_attractor
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	bool Phenotype<N,I,O>::decide_input(const unsigned int index, 
+					    const std::array<parameter_type, I>& inputs) const {
+		//one decision boundary, giving the boolean input to the network at index
+		const std::array<parameter_type, I+1>& w = decoded->input_decisions[index]; //shorthand
+		const std::array<parameter_type, I>& x = inputs; //value, dvalue, persistence
+		return ( sum_type(w[0])*x[0] + sum_type(w[1])*x[1] + sum_type(w[2])*x[2] 
+			 + sum_type(w[3])*unit() ) > 0;
+	} //decide_input
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	void Phenotype<N,I,O>::update_outputs() {
+		/*
+		Calculates and stores current output values. Each output-facing gene adds
+		its row of weights to all O sums at once if it is on: a masked sum, which
+		compiles to a blend (or AND) of one weight vector per gene instead of O 
+		float-by-bool products. Genes are added in descending order, as before.
+		In fixed point, the sums are exact 32-bit integers.
+		*/
+		std::array<sum_type, O> sums;
+		sums.fill(0);
+		unsigned int i, j;
+		for(j=N; j-- > 0; ) {
+			const bool on = state[N*N+j];
+			const std::array<parameter_type, O>& v = decoded->output_weights[j]; //shorthand
+			for(i=0; i<O; ++i) sums[i] += on ? sum_type(v[i]) : sum_type(0);
 		}
 		//run each element of output through a sigmoid
+		std::array<real_type, O> outputs;
+		for(i=0; i<O; ++i) outputs[i] = sigmoid( from_sum(sums[i]) );
+		
 		//for the sake of portability, these should not be named 
-		//put in another loop?
-		learning_rate_val = sigmoid(outputs[0]);
-		momentum_val 	  = sigmoid(outputs[1]);
-		weight_decay_val  = sigmoid(outputs[2]);
-		forget_factor_val = sigmoid(outputs[3]);
-		kill_link_prob	  = sigmoid(outputs[4]);
-		make_link_prob 	  = sigmoid(outputs[5]);
-		make_node_prob	  = sigmoid(outputs[6]);
-	} //run
+		learning_rate_val = outputs[0];
+		momentum_val 	  = outputs[1];
+		weight_decay_val  = outputs[2];
+		forget_factor_val = outputs[3];
+		kill_link_prob	  = outputs[4];
+		make_link_prob 	  = outputs[5];
+		make_node_prob	  = outputs[6];
+	} //update_outputs
 	
 	template<unsigned int N, unsigned int I, unsigned int O>
-	real_type Phenotype<N,I,O>::sigmoid(const real_type x) const {
-		return 1/(1 + exp(-x));
-	}
+	real_type Phenotype<N,I,O>::sigmoid(const real_type x) {
+	#ifdef JOHN_PRECISE_SIGMOID
+		return sigmoid_precise(x);
+	#else
+		return sigmoid_fast(x);
+	#endif
+	} //sigmoid
 	
 	template<unsigned int N, unsigned int I, unsigned int O>
-	bool Phenotype<N,I,O>::gene_fcn(const unsigned int gene_index, const bool a, const bool b) const {
-		if(a) {
-			if(b) return functions[gene_index][3];
-			else  return functions[gene_index][2];
-		} else {
-			if(b) return functions[gene_index][1];
-			else  return functions[gene_index][0];
-		}
+	real_type Phenotype<N,I,O>::sigmoid_precise(const real_type x) {
+		//reference version, through the double precision exp
+		return 1/(1 + std::exp( -static_cast<double>(x) ));
+	} //sigmoid_precise
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	real_type Phenotype<N,I,O>::sigmoid_fast(const real_type x) {
+		/*
+		1/(1+exp(-x)) without a call to exp, so that loops over it vectorize. 
+		exp(-x) is written as 2^t, with t = -x*log2(e) split into the nearest 
+		integer r, which goes straight into the exponent bits, and a remainder f in
+		[-0.5, 0.5]. 2^f is the degree 6 minimax polynomial of Cephes' exp2f, with
+		relative error below 2e-7. Since the derivative of the sigmoid is at most 
+		1/4, the result is within about 1.2e-7 (2 ulp) of sigmoid_precise, over 
+		every float in [-100, 100]; against the exact sigmoid, the worst error is 
+		9.5e-8. Relative error grows with the rounding of t in the far negative 
+		tail, to 4e-6 at x = -80.
+		t is clamped to [-126, 126], so large inputs saturate instead of 
+		overflowing. Every step is branch-free. 
+		*/
+		float t = -static_cast<float>(x) * 1.44269504088896341f;
+		t = std::min(std::max(t, -126.0f), 126.0f);
+		float r = (t + 12582912.0f) - 12582912.0f; //round to nearest, 1.5*2^23
+		float f = t - r;
+		
+		float p = 1.535336188319500e-4f;
+		p = p*f + 1.339887440266574e-3f;
+		p = p*f + 9.618437357674640e-3f;
+		p = p*f + 5.550332471162809e-2f;
+		p = p*f + 2.402264791363012e-1f;
+		p = p*f + 6.931472028550421e-1f;
+		p = p*f + 1.0f;
+		
+		std::int32_t bits = (static_cast<std::int32_t>(r) + 127) << 23; //2^r
+		float scale;
+		std::memcpy(&scale, &bits, sizeof(scale));
+		return 1/(1 + p*scale);
+	} //sigmoid_fast
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	bool Phenotype<N,I,O>::gene_fcn(const Gene<N>& gene, const bool a, const bool b) const {
+		return (gene.table >> (2*a + b)) & 1; //table lookup instead of branches
 	}
 	
 	template<unsigned int N, unsigned int I, unsigned int O>
-	bool Phenotype<N,I,O>::flip_coin(const real_type probability) {
+	bool Phenotype<N,I,O>::flip_coin(const real_type probability) const {
 		//generate random bit from given probability
-		random_bit = std::bernoulli_distribution(probability);
+		std::bernoulli_distribution random_bit(probability);
 		return random_bit(generator);
 	} //flip_coin
 	
@@ -22,11 +22,31 @@
 */
 
 #include <random>
+#include <algorithm>
 #include <array>
 #include <bitset>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
 
 namespace john {
 
+	template<unsigned int N, unsigned int I, unsigned int O, unsigned int W>
+	class PhenotypeSlice;
+	template<unsigned int N, unsigned int I, unsigned int O>
+	class PhenotypeBatch;
+	
+	template<unsigned int N>
+	struct Gene {
+		//one instruction of a compiled gene network (3 bytes for N<16, 6 otherwise)
+		typename gene_index<N>::type source[2]; //indices of input states
+		std::uint8_t table; //boolean function of two inputs: bit 2*a+b is f(a,b)
+	};
+
 	template<unsigned int N, unsigned int I, unsigned int O>
 	class Phenotype {
 	/*
@@ -34,19 +54,95 @@ namespace john {
 		network, runs that network, and stores the resulting learning parameters. 
 		Parsing is done in the constructor. The run() method steps the gene network
 		forward one step and recalculates the learning parameters. 
+		
+		The constructor compiles the network into a flat program of packed Gene 
+		records, so run() is a single linear pass that stays in L1 cache for N up
+		to 32 (6 KB), and each gene is a branch-free table lookup. Genes that cannot
+		influence the outputs, directly or through other genes, are left out of 
+		run() entirely; their states are simply never updated. 
+		
+		With fixed boolean inputs, the network is deterministic, so it eventually
+		falls into a fixed point or a limit cycle (an attractor). run() keeps a 
+		small ring of recent states, and once a state repeats it replays the cached
+		outputs of the cycle instead of stepping the network, until the boolean 
+		inputs change. In that mode state is only brought up to date when needed.
+		
+		In incremental mode (set_incremental), run() only evaluates the genes 
+		downstream of states that flipped, and only recalculates the outputs when 
+		an output-facing gene flipped. Results are identical to the full sweep.
+		
+		Everything parsed from the genome is kept in a Decoded object that never 
+		changes afterwards, so Phenotypes of identical genomes can share one 
+		(see GenomeCache) instead of each decoding its own copy. 
+		
+		With JOHN_FIXED_POINT, decision boundaries and output weights are stored 
+		as Q8.7 fixed point (every decoded value is within 255 of zero and is 
+		rounded to the nearest 1/128), which halves their memory. Inputs are 
+		rounded the same way, and clamped to +/-128 so that a boundary cannot 
+		overflow its 32-bit sum. Only the output sums leave fixed point, on their
+		way into the sigmoid.
 	*/
+	public:
+		struct Decoded {
+			//compiled network: input links and boolean function of each gene, in 
+			//the order run() streams through them
+			std::array< Gene<N>, N*N > program;
+			//genes that can reach an output (the rest are never evaluated), ascending
+			std::array< typename gene_index<N>::type, N*N > live;
+			unsigned int live_size;
+			//inverse of the links of live genes, for incremental evaluation
+			std::array< unsigned int, N*N+N+1 > fanout_begin; //offsets into fanout by source
+			std::array< typename gene_index<N>::type, 2*N*N > fanout; //reading genes
+			//input decision boundaries and biases to decide boolean inputs
+			std::array< std::array<parameter_type, I+1>, N > input_decisions; //rows<columns>
+			//weights to calculate outputs from boolean network
+			std::array< std::array<parameter_type, O>, N > output_weights; //one row per gene
+		};
+		//from pool if one is given (see GenomeCache), or else from the heap
+		static std::shared_ptr<const Decoded> decode(const Genotype<N,I,O>& genome, 
+							     BlockPool* pool=NULL);
+		
 	private:
 		//unsigned long binary_to_gray(unsigned long num) { return (num>>1) ^ num; }
-		unsigned long gray_to_binary(unsigned long num);
-		bool flip_coin(const real_type probability);
-		bool gene_fcn(const unsigned int gene_index, const bool a, const bool b) const;
-		real_type sigmoid(const real_type x) const;
+		static constexpr std::uint64_t gray_to_binary(const std::uint64_t num, 
+							      const unsigned int shift=1) {
+			//a single return statement, so this is constexpr under C++11
+			return (shift < 64) ? gray_to_binary(num ^ (num >> shift), 2*shift) : num;
+		}
+		static constexpr std::uint8_t reverse_nibble(const std::uint64_t x) {
+			return ((x & 1) << 3) | ((x & 2) << 1) | ((x & 4) >> 1) | ((x & 8) >> 3);
+		}
+		bool flip_coin(const real_type probability) const;
+		bool gene_fcn(const Gene<N>& gene, const bool a, const bool b) const;
+		static real_type sigmoid(const real_type x); //one of the below, see John.h
+		static real_type sigmoid_precise(const real_type x);
+		static real_type sigmoid_fast(const real_type x); //within about 1.2e-7 (2 ulp) of precise
+		bool decide_input(const unsigned int index, 
+				  const std::array<parameter_type, I>& inputs) const;
+		void update_outputs(); //from the output-facing genes in state
+		void remember(); //record state after a step, detecting cycles
+		void recall(const unsigned int entry); //replay the outputs of a recorded step
+		void forget_attractor(); //clear the record, restoring state if replaying
+		void step_all(); //evaluate every live gene
+		bool step_changes(); //evaluate genes downstream of changes only
 		
-		//following only called by constructor
-		template<unsigned int N> 
-		unsigned long get_integer(std::bitset<N>& sequence, unsigned int start) const;
-		template<unsigned int N>
-		real_type get_real(std::bitset<N>& sequence, unsigned int start) const;
+		//following only called by decode
+		static void find_live_genes(Decoded& decoded);
+		static void build_fanout(Decoded& decoded);
+		static parameter_type get_parameter(const std::uint64_t field);
+		static std::vector<parameter_type> build_parameter_table();
+		
+		//conversions to and from fixed point (no-ops otherwise)
+		static parameter_type to_parameter(const real_type x);
+		static parameter_type to_input(const real_type x); //clamped to +/-128
+		static real_type from_sum(const sum_type sum); //of parameters alone
+		static constexpr sum_type unit() { //1 in the scale of products
+		#ifdef JOHN_FIXED_POINT
+			return sum_type(1) << fraction_bits; 
+		#else
+			return 1;
+		#endif
+		}
 		
 		///////////////////////
 		//current output values
@@ -56,33 +152,47 @@ namespace john {
 		real_type kill_link_prob, make_link_prob, make_node_prob; 
 		
 		////////////////////////////
-		//genetic network parameters
-		//array of pairs of input links
-		std::array< std::array<unsigned int,2>, N*N > links; //genes<inputs>
-		//boolean functions of two inputs
-		std::array< std::bitset<4>, N*N > functions; //order: 00, 01, 10, 11
-		//input decision boundaries and biases to decide boolean inputs
-		std::array< std::array<real_type, I+1>, N > input_decisions; //rows<columns>
-		//weights to calculate outputs from boolean network
-		std::array< std::array<real_type, N>, O > output_weights; //rows<columns>
+		//genetic network parameters, possibly shared with other Phenotypes
+		std::shared_ptr<const Decoded> decoded;
 		
 		/////////////////////////
 		//current internal states
 		//current states of boolean switches (genes)
 		std::bitset<N*N+N> state;
-		//random number generator
-		std::minstd_rand generator;
+		//recent states under the current inputs, to detect fixed points and cycles
+		struct Step {
+			std::size_t hash;
+			std::bitset<N*N+N> state;
+			std::array<real_type, O> outputs; //after the sigmoid
+		};
+		static const unsigned int memo_capacity = 8; //longest cycle detected
+		std::array<Step, memo_capacity> memo; //ring buffer
+		unsigned int memo_head, memo_size; //next entry to write, valid entries
+		std::bitset<N> memo_inputs; //boolean inputs of every recorded step
+		unsigned int cycle_start, cycle_length, cycle_phase; //cycle_length=0 if none
+		//incremental evaluation: states flipped since their readers were evaluated
+		bool incremental, sweep_needed; //sweep_needed if changes is not trustworthy
+		std::array< typename gene_index<N>::type, N*N+N > changes;
+		unsigned int changes_size;
+		std::bitset<N*N> dirty; //scratch space for step_changes
+		std::array< typename gene_index<N>::type, N*N > dirty_genes;
+		//random number generator, stream (seed, generation, genome ID, express)
+		mutable random_type generator;
 		
 	public:
 		Phenotype() = delete;
-		explicit Phenotype(Genotype<N>& genome);
+		explicit Phenotype(Genotype<N,I,O>& genome);
+		//nDecoded must come from decode() of genome or of an identical Genotype
+		Phenotype(Genotype<N,I,O>& genome, std::shared_ptr<const Decoded> nDecoded);
 		Phenotype(const Phenotype& rhs) = delete;
 		//Phenotype(Phenotype&& rhs);
 		Phenotype& operator=(const Phenotype& rhs) = delete;
 		//Phenotype& operator=(Phenotype&& rhs);
 		~Phenotype() = default;
 		
-		void run(const real_type value; const real_type dvalue; const real_type persistence);
+		void run(const real_type value, const real_type dvalue, const real_type persistence);
+		void set_incremental(const bool bIncremental);
+		bool is_incremental() const { return incremental; }
 		
 		inline real_type learning_rate() const { return learning_rate_val; }
 		inline real_type momentum() const { return momentum_val; }
@@ -92,6 +202,10 @@ namespace john {
 		inline bool make_link() const { return flip_coin(make_link_prob); }
 		inline bool make_node() const { return flip_coin(make_node_prob); }
 		
+		template<unsigned int, unsigned int, unsigned int, unsigned int> 
+		friend class PhenotypeSlice; //runs many Phenotypes' networks at once
+		friend class PhenotypeBatch<N,I,O>; //runs many neurons' Phenotypes at once
+		
 	}; //class Phenotype
 
 } //namespace john
@@ -0,0 +1,196 @@
+/*
+    John: an evolutionary algorithm for genetic networks
+    Copyright (C) 2012  Jack Hall
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    e-mail: jackwhall7@gmail.com
+*/
+
+namespace john {
+
+	template<unsigned int N, unsigned int I, unsigned int O>
+	PhenotypeBatch<N,I,O>::PhenotypeBatch(const unsigned int nCapacity) 
+		: capacity_val(nCapacity), size_val(0), 
+		  decisions(N*(I+1)*nCapacity, 0), weights(O*N*nCapacity, 0), 
+		  program(), targets(), program_begin(1, 0), states(), 
+		  values(nCapacity, 0), dvalues(nCapacity, 0), persistences(nCapacity, 0), 
+		  inputs(N*nCapacity, 0), genes(N*nCapacity, 0), sums(nCapacity, 0), 
+		  outputs(O*nCapacity, 0), 
+		  settled(nCapacity, 0), refresh(nCapacity, 0) {
+		program.reserve(N*N*nCapacity);
+		targets.reserve(N*N*nCapacity);
+		program_begin.reserve(nCapacity+1);
+		states.reserve(nCapacity);
+	} //constructor
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	bool PhenotypeBatch<N,I,O>::add(Phenotype<N,I,O>& phenotype) {
+		/*
+		Copies a Phenotype into the next neuron of the batch, scattering its 
+		parameters into the arrays. Returns false if the batch is full.
+		*/
+		if(size_val == capacity_val) return false;
+		unsigned int neuron = size_val++;
+		unsigned int i, j, k;
+		const typename Phenotype<N,I,O>::Decoded& decoded = *phenotype.decoded; //shorthand
+		
+		for(i=0; i<N; ++i) 
+			for(j=0; j<I+1; ++j) 
+				decisions[(i*(I+1) + j)*capacity_val + neuron] = decoded.input_decisions[i][j];
+		for(i=0; i<O; ++i) 
+			for(j=0; j<N; ++j) 
+				weights[(i*N + j)*capacity_val + neuron] = decoded.output_weights[j][i];
+		
+		for(k=0; k<decoded.live_size; ++k) {
+			program.push_back( decoded.program[ decoded.live[k] ] );
+			targets.push_back( decoded.live[k] );
+		}
+		program_begin.push_back( program.size() );
+		
+		phenotype.forget_attractor(); //brings state up to date
+		states.emplace_back();
+		for(i=0; i<N*N+N; ++i) states.back()[i] = phenotype.state[i];
+		for(i=0; i<N; ++i) genes[i*capacity_val + neuron] = phenotype.state[N*N+i];
+		settled[neuron] = false; //the first run always steps and calculates outputs
+		refresh[neuron] = true;
+		const real_type current[] = {phenotype.learning_rate_val, phenotype.momentum_val, 
+					     phenotype.weight_decay_val, phenotype.forget_factor_val, 
+					     phenotype.kill_link_prob, phenotype.make_link_prob, 
+					     phenotype.make_node_prob};
+		for(i=0; i<O; ++i) outputs[i*capacity_val + neuron] = current[i];
+		return true;
+	} //add
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	void PhenotypeBatch<N,I,O>::clear() {
+		size_val = 0;
+		program.clear();
+		targets.clear();
+		program_begin.assign(1, 0);
+		states.clear();
+	} //clear
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	void PhenotypeBatch<N,I,O>::run(const real_type* values, const real_type* dvalues, 
+					const real_type* persistences) {
+		decide_inputs(values, dvalues, persistences);
+		step_networks();
+		update_outputs();
+	} //run
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	void PhenotypeBatch<N,I,O>::decide_inputs(const real_type* raw_values, 
+						  const real_type* raw_dvalues, 
+						  const real_type* raw_persistences) {
+		//same boundary as Phenotype::decide_input, for every neuron at once
+		unsigned int i, m, M = size_val;
+		for(m=0; m<M; ++m) {
+			values[m] = Phenotype<N,I,O>::to_input(raw_values[m]);
+			dvalues[m] = Phenotype<N,I,O>::to_input(raw_dvalues[m]);
+			persistences[m] = Phenotype<N,I,O>::to_input(raw_persistences[m]);
+		}
+		
+		const sum_type unit = Phenotype<N,I,O>::unit();
+		for(i=0; i<N; ++i) {
+			const parameter_type* w0 = &decisions[(i*(I+1) + 0)*capacity_val];
+			const parameter_type* w1 = &decisions[(i*(I+1) + 1)*capacity_val];
+			const parameter_type* w2 = &decisions[(i*(I+1) + 2)*capacity_val];
+			const parameter_type* w3 = &decisions[(i*(I+1) + 3)*capacity_val];
+			std::uint8_t* decided = &inputs[i*capacity_val];
+			for(m=0; m<M; ++m) 
+				decided[m] = ( sum_type(w0[m])*values[m] + sum_type(w1[m])*dvalues[m] 
+					       + sum_type(w2[m])*persistences[m] + sum_type(w3[m])*unit ) > 0;
+		}
+	} //decide_inputs
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	void PhenotypeBatch<N,I,O>::step_networks() {
+		/*
+		A full step of every network, as Phenotype::step_all, one neuron at a time.
+		States are kept a byte each, so every gene is two loads, a shift and a 
+		store, without the masking of bitset. A settled network with unchanged 
+		inputs would step to the same state, so it is skipped. 
+		*/
+		unsigned int i, k, m;
+		std::array<std::uint8_t, N*N+N> next;
+		for(m=0; m<size_val; ++m) {
+			std::array<std::uint8_t, N*N+N>& state = states[m];
+			bool inputs_changed = false;
+			for(i=0; i<N; ++i) {
+				inputs_changed |= state[i] != inputs[i*capacity_val + m];
+				state[i] = inputs[i*capacity_val + m];
+			}
+			if(settled[m] && !inputs_changed) continue;
+			
+			next = state;
+			for(k=program_begin[m]; k<program_begin[m+1]; ++k) {
+				const Gene<N>& gene = program[k];
+				unsigned int row = 2*state[ gene.source[0] ] + state[ gene.source[1] ];
+				next[ targets[k] + N ] = (gene.table >> row) & 1;
+			}
+			
+			for(i=N*N; i<N*N+N; ++i) refresh[m] |= next[i] != state[i];
+			settled[m] = (next == state);
+			state = next;
+			for(i=0; i<N; ++i) genes[i*capacity_val + m] = state[N*N+i];
+		}
+	} //step_networks
+	
+	template<unsigned int N, unsigned int I, unsigned int O>
+	void PhenotypeBatch<N,I,O>::update_outputs() {
+		/*
+		Masked sums of the output weights under the output-facing genes, then 
+		sigmoids. Terms are added in the same order as Phenotype::update_outputs, 
+		so results are bit-identical to it. Outputs only change when a neuron's 
+		output-facing genes flip. If few neurons need a refresh, only those are
+		recalculated, one at a time. Otherwise every neuron is recalculated as 
+		loops over neurons, which vectorize; recalculating an unchanged neuron 
+		gives back the same outputs. 
+		*/
+		unsigned int i, j, m, M = size_val, stale = 0;
+		for(m=0; m<M; ++m) stale += refresh[m];
+		
+		if(2*stale <= M) {
+			for(m=0; m<M; ++m) {
+				if(!refresh[m]) continue;
+				for(i=0; i<O; ++i) {
+					sum_type sum = 0;
+					for(j=N; j-- > 0; ) 
+						sum += genes[j*capacity_val + m] ? 
+						       sum_type(weights[(i*N + j)*capacity_val + m]) : sum_type(0);
+					outputs[i*capacity_val + m] = 
+						Phenotype<N,I,O>::sigmoid( Phenotype<N,I,O>::from_sum(sum) );
+				}
+				refresh[m] = false;
+			}
+			return;
+		}
+		
+		for(i=0; i<O; ++i) {
+			for(m=0; m<M; ++m) sums[m] = 0;
+			for(j=N; j-- > 0; ) {
+				const parameter_type* w = &weights[(i*N + j)*capacity_val];
+				const std::uint8_t* g = &genes[j*capacity_val];
+				for(m=0; m<M; ++m) sums[m] += g[m] ? sum_type(w[m]) : sum_type(0);
+			}
+			real_type* result = &outputs[i*capacity_val];
+			for(m=0; m<M; ++m) 
+				result[m] = Phenotype<N,I,O>::sigmoid( Phenotype<N,I,O>::from_sum(sums[m]) );
+		}
+		for(m=0; m<M; ++m) refresh[m] = false;
+	} //update_outputs
+
+} //namespace john
+
@@ -0,0 +1,116 @@
+#ifndef PhenotypeBatch_h
+#define PhenotypeBatch_h
+
+/*
+    John: an evolutionary algorithm for genetic networks
+    Copyright (C) 2012  Jack Hall
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    e-mail: jackwhall7@gmail.com
+*/
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace john {
+
+	template<unsigned int N, unsigned int I, unsigned int O>
+	class PhenotypeBatch {
+	/*
+		A PhenotypeBatch runs the Phenotypes of up to capacity() neurons in one
+		call per training step. Decoded parameters are stored as structure of 
+		arrays: each coefficient of each decision boundary, and each output weight,
+		is one contiguous array with an element per neuron. The decision boundaries,
+		the output dot products and the sigmoids are then plain loops over neurons
+		that the compiler can vectorize (GCC 12 does so at -O3, since at -O2 it 
+		will not add the runtime aliasing checks they need). Only the gene 
+		networks are stepped one neuron at a time, through each neuron's live 
+		genes. With JOHN_FIXED_POINT, the boundaries and sums are 16 and 32-bit 
+		integer loops, twice as wide. 
+		
+		Like Phenotype, the batch exploits attractors, here only fixed points: a 
+		network whose last step changed nothing, and whose inputs have not changed
+		since, is not stepped again. Outputs are masked sums of the weights, 
+		followed by Phenotype::sigmoid, and are bit-identical to Phenotype::run. 
+		They are only recalculated for neurons whose output-facing genes flipped,
+		one neuron at a time when those are few, and as whole loops otherwise. 
+		
+		add() copies a Phenotype's decoded parameters and current state; the batch
+		does not write anything back to it. Each run() is equivalent to a step of
+		Phenotype::run; outputs are read as arrays, one element per neuron in 
+		the order of add(). 
+	*/
+	private:
+		typedef typename gene_index<N>::type index_type;
+		
+		unsigned int capacity_val, size_val;
+		//decision boundaries: (I+1) coefficients for each of N inputs, by neuron
+		std::vector<parameter_type> decisions; //[(input*(I+1) + coefficient)*capacity + neuron]
+		//output weights: N for each of O outputs, by neuron
+		std::vector<parameter_type> weights; //[(output*N + gene)*capacity + neuron]
+		//live genes of every neuron, in one array
+		std::vector< Gene<N> > program;
+		std::vector<index_type> targets; //gene updated by each instruction of program
+		std::vector<unsigned int> program_begin; //first instruction of each neuron
+		std::vector< std::array<std::uint8_t, N*N+N> > states; //by neuron, a byte per state
+		//scratch space and results, by neuron
+		std::vector<parameter_type> values, dvalues, persistences; //after to_input
+		std::vector<std::uint8_t> inputs; //[input*capacity + neuron]
+		std::vector<std::uint8_t> genes; //output-facing gene states, [gene*capacity + neuron]
+		std::vector<sum_type> sums; //of one output
+		std::vector<real_type> outputs; //[output*capacity + neuron]
+		std::vector<std::uint8_t> settled; //by neuron, state is a fixed point of its inputs
+		std::vector<std::uint8_t> refresh; //by neuron, outputs must be recalculated
+		
+		void decide_inputs(const real_type* raw_values, const real_type* raw_dvalues, 
+				   const real_type* raw_persistences);
+		void step_networks();
+		void update_outputs();
+		
+	public:
+		PhenotypeBatch() = delete;
+		explicit PhenotypeBatch(const unsigned int nCapacity);
+		PhenotypeBatch(const PhenotypeBatch& rhs) = delete;
+		PhenotypeBatch& operator=(const PhenotypeBatch& rhs) = delete;
+		~PhenotypeBatch() = default;
+		
+		unsigned int size() const { return size_val; }
+		unsigned int capacity() const { return capacity_val; }
+		bool add(Phenotype<N,I,O>& phenotype);
+		void clear();
+		
+		//one value, dvalue and persistence per neuron, in the order of add()
+		void run(const real_type* values, const real_type* dvalues, 
+			 const real_type* persistences);
+		
+		//size() results each, in the order of add()
+		const real_type* output(const unsigned int index) const { 
+			return &outputs[index*capacity_val]; 
+		}
+		const real_type* learning_rate() const { return output(0); }
+		const real_type* momentum() const { return output(1); }
+		const real_type* weight_decay() const { return output(2); }
+		const real_type* forget_factor() const { return output(3); }
+		const real_type* kill_link_prob() const { return output(4); }
+		const real_type* make_link_prob() const { return output(5); }
+		const real_type* make_node_prob() const { return output(6); }
+		
+	}; //class PhenotypeBatch
+
+} //namespace john
+
+#endif
+
@@ -0,0 +1,133 @@
+/*
+    John: an evolutionary algorithm for genetic networks
+    Copyright (C) 2012  Jack Hall
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    e-mail: jackwhall7@gmail.com
+*/
+
+namespace john {
+
+	template<unsigned int N, unsigned int I, unsigned int O, unsigned int W>
+	PhenotypeSlice<N,I,O,W>::PhenotypeSlice() 
+		: phenotypes(), size_val(0), sources(), tables(), state(), new_state() {
+		phenotypes.fill(NULL);
+		for(auto& gene : tables) for(auto& row : gene) row.fill(0);
+		for(auto& gene : state) gene.fill(0);
+	} //constructor
+	
+	template<unsigned int N, unsigned int I, unsigned int O, unsigned int W>
+	bool PhenotypeSlice<N,I,O,W>::add(Phenotype<N,I,O>& phenotype) {
+		/*
+		Adds a Phenotype as the next lane, copying its links, truth tables and 
+		current state. Returns false if the slice is full. 
+		*/
+		if(size_val == 64*W) return false;
+		unsigned int i, j;
+		
+		phenotype.forget_attractor(); //brings state up to date
+		unsigned int lane = size_val++;
+		unsigned int word = lane / 64;
+		std::uint64_t bit = std::uint64_t(1) << (lane % 64);
+		phenotypes[lane] = &phenotype;
+		
+		for(i=0; i<N*N; ++i) {
+			const Gene<N>& gene = phenotype.decoded->program[i]; //shorthand
+			for(j=0; j<2; ++j) {
+				std::vector<Source>& inputs = sources[i][j]; //shorthand
+				auto it = inputs.begin();
+				while(it != inputs.end() && it->index != gene.source[j]) ++it;
+				if(it == inputs.end()) {
+					inputs.push_back( Source{gene.source[j], lane_mask()} );
+					it = inputs.end() - 1;
+					it->lanes.fill(0);
+				}
+				it->lanes[word] |= bit;
+			}
+			for(j=0; j<4; ++j)
+				if( (gene.table >> j) & 1 ) tables[i][j][word] |= bit;
+		}
+		
+		for(i=0; i<N*N+N; ++i)
+			if(phenotype.state[i]) state[i][word] |= bit;
+		
+		return true;
+	} //add
+	
+	template<unsigned int N, unsigned int I, unsigned int O, unsigned int W>
+	void PhenotypeSlice<N,I,O,W>::sync() const {
+		//copies the whole state of every lane back to its Phenotype
+		unsigned int lane, i;
+		for(lane=0; lane<size_val; ++lane) {
+			unsigned int word = lane / 64, shift = lane % 64;
+			for(i=0; i<N*N+N; ++i) 
+				phenotypes[lane]->state[i] = (state[i][word] >> shift) & 1;
+		}
+	} //sync
+	
+	template<unsigned int N, unsigned int I, unsigned int O, unsigned int W>
+	void PhenotypeSlice<N,I,O,W>::run(const real_type* values, const real_type* dvalues, 
+					  const real_type* persistences) {
+		unsigned int lane, word, shift, i, w;
+		
+		//run decision boundaries on inputs, one lane at a time
+		for(i=0; i<N; ++i) state[i].fill(0);
+		for(lane=0; lane<size_val; ++lane) {
+			word = lane / 64; 
+			shift = lane % 64;
+			const std::array<parameter_type, I> x = { {
+				Phenotype<N,I,O>::to_input(values[lane]), 
+				Phenotype<N,I,O>::to_input(dvalues[lane]), 
+				Phenotype<N,I,O>::to_input(persistences[lane])} };
+			for(i=0; i<N; ++i) {
+				std::uint64_t bit = phenotypes[lane]->decide_input(i, x);
+				state[i][word] |= bit << shift;
+			}
+		}
+		
+		//evaluate boolean network in every lane at once
+		lane_mask a, b;
+		for(i=0; i<N*N; ++i) {
+			//gather each input from the source genes of its lanes
+			a.fill(0);
+			b.fill(0);
+			for(const Source& source : sources[i][0]) 
+				for(w=0; w<W; ++w) a[w] |= state[source.index][w] & source.lanes[w];
+			for(const Source& source : sources[i][1]) 
+				for(w=0; w<W; ++w) b[w] |= state[source.index][w] & source.lanes[w];
+			const std::array<lane_mask,4>& f = tables[i];
+			for(w=0; w<W; ++w) 
+				new_state[i][w] = (~a[w] & ~b[w] & f[0][w]) | (~a[w] & b[w] & f[1][w]) 
+						| ( a[w] & ~b[w] & f[2][w]) | ( a[w] & b[w] & f[3][w]);
+		}
+		for(i=0; i<N*N; ++i) state[i+N] = new_state[i];
+		
+		//write back inputs and output-facing genes, then calculate outputs per lane
+		for(lane=0; lane<size_val; ++lane) {
+			Phenotype<N,I,O>& phenotype = *phenotypes[lane];
+			phenotype.forget_attractor();
+			phenotype.sweep_needed = true; //state is changed behind its back
+			word = lane / 64; 
+			shift = lane % 64;
+			for(i=0; i<N; ++i) {
+				phenotype.state[i] = (state[i][word] >> shift) & 1;
+				phenotype.state[N*N+i] = (state[N*N+i][word] >> shift) & 1;
+			}
+			phenotype.update_outputs();
+		}
+	} //run
+
+} //namespace john
+
@@ -0,0 +1,85 @@
+#ifndef PhenotypeSlice_h
+#define PhenotypeSlice_h
+
+/*
+    John: an evolutionary algorithm for genetic networks
+    Copyright (C) 2012  Jack Hall
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    e-mail: jackwhall7@gmail.com
+*/
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace john {
+
+	//N, I and O are as in Phenotype
+	//W is the number of 64-bit words per lane mask (64*W Phenotypes per slice)
+	template<unsigned int N, unsigned int I, unsigned int O, unsigned int W=1>
+	class PhenotypeSlice {
+	/*
+		A PhenotypeSlice runs the gene networks of up to 64*W Phenotypes at once by
+		bit slicing: every gene's state is stored as a lane mask, where bit l 
+		belongs to the lth Phenotype. Each gene's truth table is also stored as four
+		lane masks, so one branch-free boolean expression updates that gene in every
+		lane. W=4 or W=8 lets the compiler use AVX2 or AVX-512 registers for the 
+		inner loops. 
+		
+		Lanes may be wired differently. Each input of each gene keeps the distinct
+		source genes its lanes read, with a lane mask of the lanes reading each; 
+		the input is gathered as the OR of every source's state masked by its 
+		lanes. Lanes that share their links (the usual case is many neurons 
+		decoded from one Genotype) cost a single AND per input. Truth tables, 
+		decision boundaries and output weights may differ per lane as well. 
+		Results are bit-identical to Phenotype::run. While a Phenotype belongs to a 
+		slice, only its inputs and output-facing genes are written back after each
+		run; call sync() before running it on its own again. 
+	*/
+	private:
+		typedef std::array<std::uint64_t, W> lane_mask;
+		
+		std::array<Phenotype<N,I,O>*, 64*W> phenotypes;
+		unsigned int size_val;
+		struct Source {
+			unsigned int index; //into state
+			lane_mask lanes; //lanes that read it
+		};
+		std::array< std::array<std::vector<Source>,2>, N*N > sources; //by gene and input
+		std::array< std::array<lane_mask,4>, N*N > tables; //order: 00, 01, 10, 11
+		std::array<lane_mask, N*N+N> state;
+		std::array<lane_mask, N*N> new_state; //scratch space for run()
+		
+	public:
+		PhenotypeSlice();
+		PhenotypeSlice(const PhenotypeSlice& rhs) = delete;
+		PhenotypeSlice& operator=(const PhenotypeSlice& rhs) = delete;
+		~PhenotypeSlice() = default;
+		
+		unsigned int size() const { return size_val; }
+		bool add(Phenotype<N,I,O>& phenotype);
+		void sync() const;
+		
+		//one value, dvalue and persistence per lane, in the order of add()
+		void run(const real_type* values, const real_type* dvalues, 
+			 const real_type* persistences);
+		
+	}; //class PhenotypeSlice
+
+} //namespace john
+
+#endif
+
@@ -0,0 +1,113 @@
+#ifndef Philox_h
+#define Philox_h
+
+/*
+    John: an evolutionary algorithm for genetic networks
+    Copyright (C) 2012  Jack Hall
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    e-mail: jackwhall7@gmail.com
+*/
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+namespace john {
+
+	class Philox {
+	/*
+		Philox4x32-10 is a counter-based generator (Salmon et al., Random123): 
+		each block of 128 random bits is a keyed bijection of a 128-bit counter,
+		with no state carried from one block to the next. A stream is named by
+		(seed, generation, ID, purpose): the seed is the key, and the other three 
+		fill three counter words, leaving the fourth to count blocks. Any thread 
+		can therefore reproduce the stream of any individual, and discard() skips 
+		ahead in O(1). A stream holds 2^33 64-bit words. 
+		
+		generate() fills an array with consecutive words; its blocks are 
+		independent, so the loop is open to vectorization. 
+	*/
+	public:
+		typedef std::uint64_t result_type;
+		
+	private:
+		std::array<std::uint32_t, 2> key;
+		std::uint32_t generation, ID, purpose; //counter words 1-3
+		std::uint64_t position; //index of the next 64-bit word in the stream
+		std::array<std::uint64_t, 2> buffer; //words of the current block
+		std::uint64_t buffered_block; //block in buffer, or ~0 if none
+		
+		void block(const std::uint32_t index, std::uint64_t* out) const {
+			//ten Philox rounds, with the key bumped by the Weyl constants between them
+			std::uint32_t c0 = index, c1 = generation, c2 = ID, c3 = purpose;
+			std::uint32_t k0 = key[0], k1 = key[1];
+			for(int round=0; round<10; ++round) {
+				if(round > 0) { k0 += 0x9E3779B9; k1 += 0xBB67AE85; }
+				std::uint64_t p0 = std::uint64_t(0xD2511F53) * c0;
+				std::uint64_t p1 = std::uint64_t(0xCD9E8D57) * c2;
+				std::uint32_t n0 = std::uint32_t(p1 >> 32) ^ c1 ^ k0;
+				std::uint32_t n2 = std::uint32_t(p0 >> 32) ^ c3 ^ k1;
+				c1 = std::uint32_t(p1);
+				c3 = std::uint32_t(p0);
+				c0 = n0;
+				c2 = n2;
+			}
+			out[0] = c0 | (std::uint64_t(c1) << 32);
+			out[1] = c2 | (std::uint64_t(c3) << 32);
+		}
+		
+	public:
+		Philox(const std::uint64_t seed, const std::uint32_t nGeneration, 
+		       const std::uint32_t nID, const Purpose nPurpose) 
+			: key{ {std::uint32_t(seed), std::uint32_t(seed >> 32)} }, 
+			  generation(nGeneration), ID(nID), 
+			  purpose( static_cast<std::uint32_t>(nPurpose) ),
+			  position(0), buffer(), buffered_block(~std::uint64_t(0)) {}
+		Philox(const Philox& rhs) = default;
+		Philox& operator=(const Philox& rhs) = default;
+		~Philox() = default;
+		
+		static constexpr result_type min() { return 0; }
+		static constexpr result_type max() { return ~result_type(0); }
+		
+		result_type operator()() {
+			std::uint64_t index = position / 2;
+			if(index != buffered_block) {
+				block(index, buffer.data());
+				buffered_block = index;
+			}
+			return buffer[position++ % 2];
+		}
+		
+		void discard(const std::uint64_t count) { position += count; }
+		
+		void generate(std::uint64_t* out, std::size_t count) {
+			//bulk version of operator(), a whole block per iteration
+			while(count > 0 && position % 2 != 0) { *out++ = (*this)(); --count; }
+			std::uint64_t index = position / 2;
+			std::size_t i, blocks = count / 2;
+			for(i=0; i<blocks; ++i) block(index + i, out + 2*i);
+			position += 2*blocks;
+			out += 2*blocks;
+			if(count % 2 != 0) *out = (*this)();
+		}
+		
+	}; //class Philox
+
+} //namespace john
+
+#endif
+
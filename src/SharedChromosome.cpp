@@ -0,0 +1,164 @@
+/*
+    John: an evolutionary algorithm for genetic networks
+    Copyright (C) 2012  Jack Hall
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    e-mail: jackwhall7@gmail.com
+*/
+
+namespace john {
+
+	template<unsigned int B>
+	SharedChromosome<B>::SharedChromosome(BlockPool* pPool) : hash_val(0), pool(pPool) {
+		for(Chunk*& chunk : chunks) chunk = make_chunk(pool);
+	} //constructor
+	
+	template<unsigned int B>
+	SharedChromosome<B>::SharedChromosome(const SharedChromosome& a, const SharedChromosome& b, 
+					      const unsigned int* points, const unsigned int count, 
+					      BlockPool* pPool) 
+		: hash_val(0), pool(pPool) {
+		/*
+		Multi-point crossover, as in Chromosome: points must be ascending. Bits 
+		[0, points[0]] come from a, (points[0], points[1]] from b, and so on. A 
+		chunk with no point inside it (a point on its last bit only ends a segment) 
+		is shared with the parent it comes from, as is any chunk the parents 
+		already share. Only the others are new, and are built a word at a time. 
+		*/
+		unsigned int c, k = 0, j, begin, end; //bits [begin, end) of chunk c
+		for(c=0; c<chunk_count; ++c) {
+			begin = c * chunk_bits;
+			end = begin + chunk_bits;
+			while(k < count && points[k] < begin) ++k; //k points before this chunk
+			const SharedChromosome& first = (k % 2 == 0) ? a : b;
+			const SharedChromosome& second = (k % 2 == 0) ? b : a;
+			
+			if( k == count || points[k] >= end - 1 || a.chunks[c] == b.chunks[c] ) {
+				chunks[c] = acquire(first.chunks[c]);
+				continue;
+			}
+			
+			//alternate parents at each point inside the chunk
+			chunks[c] = make_chunk(pool);
+			Chromosome<chunk_bits>& bits = chunks[c]->bits;
+			bits = first.chunks[c]->bits;
+			for(j=0; k+j < count && points[k+j] < end - 1; ++j) 
+				bits.crossover( bits, (j % 2 == 0 ? second : first).chunks[c]->bits, 
+						points[k+j] - begin );
+		}
+	} //constructor (crossover)
+	
+	template<unsigned int B>
+	SharedChromosome<B>::~SharedChromosome() {
+		for(Chunk* chunk : chunks) release(chunk);
+	} //destructor
+	
+	template<unsigned int B>
+	typename SharedChromosome<B>::Chunk* SharedChromosome<B>::make_chunk(BlockPool* pool) {
+		void* block = (pool == NULL) ? ::operator new( sizeof(Chunk) ) 
+					     : pool->allocate( sizeof(Chunk) );
+		return new(block) Chunk(pool);
+	} //make_chunk
+	
+	template<unsigned int B>
+	typename SharedChromosome<B>::Chunk* SharedChromosome<B>::acquire(Chunk* chunk) {
+		chunk->references.fetch_add(1, std::memory_order_relaxed);
+		return chunk;
+	} //acquire
+	
+	template<unsigned int B>
+	void SharedChromosome<B>::release(Chunk* chunk) {
+		if(chunk->references.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+		BlockPool* pool = chunk->pool;
+		chunk->~Chunk();
+		if(pool == NULL) ::operator delete(chunk);
+		else pool->deallocate(chunk);
+	} //release
+	
+	template<unsigned int B>
+	typename SharedChromosome<B>::Chunk& SharedChromosome<B>::writable(const unsigned int c) {
+		/*
+		Copy-on-write. A chunk referenced only by this table can be written in 
+		place, even if it was once shared; any other is copied first. Either way 
+		its hash has to be recomputed by finish().
+		*/
+		Chunk* chunk = chunks[c];
+		if(chunk->references.load(std::memory_order_acquire) != 1) {
+			Chunk* copy = make_chunk(pool);
+			copy->bits = chunk->bits;
+			release(chunk);
+			chunks[c] = chunk = copy;
+		}
+		chunk->hashed = false;
+		return *chunk;
+	} //writable
+	
+	template<unsigned int B>
+	std::uint64_t SharedChromosome<B>::field(const unsigned int start, const unsigned int width) const {
+		//as Chromosome::field, but the two words may lie in different chunks
+		unsigned int w = start / 64, offset = start % 64;
+		std::uint64_t bits = word(w) >> offset;
+		if(offset + width > 64) bits |= word(w+1) << (64 - offset);
+		return bits & ( (std::uint64_t(1) << width) - 1 );
+	} //field
+	
+	template<unsigned int B>
+	void SharedChromosome<B>::flip(const unsigned int i) {
+		writable(i / chunk_bits).bits.flip(i % chunk_bits);
+	} //flip
+	
+	template<unsigned int B>
+	void SharedChromosome<B>::assign(const unsigned int start, const unsigned int width, 
+					 const std::uint64_t value) {
+		//sets bits [start, start+width) to value, the inverse of field; width <= 64
+		const std::uint64_t mask = (width == 64) ? ~std::uint64_t(0) 
+							 : (std::uint64_t(1) << width) - 1;
+		unsigned int w = start / 64, offset = start % 64;
+		std::uint64_t* word = writable(w / chunk_words).bits.data() + w % chunk_words;
+		*word = ( *word & ~(mask << offset) ) | ( (value & mask) << offset );
+		if(offset + width > 64) {
+			++w;
+			word = writable(w / chunk_words).bits.data() + w % chunk_words;
+			*word = ( *word & ~(mask >> (64 - offset)) ) | ( (value & mask) >> (64 - offset) );
+		}
+	} //assign
+	
+	template<unsigned int B>
+	void SharedChromosome<B>::finish() {
+		/*
+		Hashes every chunk written since it was last hashed, then hashes the 
+		table of chunk hashes. Shared chunks keep the hash their first owner 
+		computed, so a child only hashes its new chunks, and since a chunk hash 
+		depends only on its bits, equal contents hash alike however they arose.
+		*/
+		Chromosome<64*chunk_count> hashes;
+		for(unsigned int c=0; c<chunk_count; ++c) {
+			if(!chunks[c]->hashed) {
+				chunks[c]->hash = chunks[c]->bits.hash();
+				chunks[c]->hashed = true;
+			}
+			hashes.data()[c] = chunks[c]->hash;
+		}
+		hash_val = hashes.hash(B);
+	} //finish
+	
+	template<unsigned int B>
+	unsigned int SharedChromosome<B>::shared_chunks(const SharedChromosome& rhs) const {
+		unsigned int count = 0;
+		for(unsigned int c=0; c<chunk_count; ++c) if(chunks[c] == rhs.chunks[c]) ++count;
+		return count;
+	} //shared_chunks
+
+} //namespace john
@@ -0,0 +1,110 @@
+#ifndef SharedChromosome_h
+#define SharedChromosome_h
+
+/*
+    John: an evolutionary algorithm for genetic networks
+    Copyright (C) 2012  Jack Hall
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    e-mail: jackwhall7@gmail.com
+*/
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace john {
+
+	//B is the number of bits
+	template<unsigned int B>
+	class SharedChromosome {
+	/*
+		A SharedChromosome is a bit string, like Chromosome, stored as a table of
+		pointers to fixed-size chunks. Chunks are reference counted and shared 
+		between SharedChromosomes: crossover takes every chunk that lies wholly 
+		within one parent's segment by reference and only builds new chunks where 
+		a crossover point falls, so a child costs a table of pointers and a chunk 
+		or two rather than a copy of the genome. 
+		
+		Writing to a chunk that is shared first replaces it with a private copy 
+		(copy-on-write). Writes are for building only: once finish() has hashed 
+		the new chunks, a SharedChromosome is treated as immutable and is normally 
+		held as shared_ptr<const SharedChromosome>, which many threads may read.
+		
+		Bits past B, up to padded_size, are always zero. Crossover points may be 
+		anywhere in [0, padded_size). 
+		
+		Chunks come from the BlockPool given to the constructor, or from the 
+		heap without one. Each chunk remembers where it came from, so it goes 
+		back there whichever SharedChromosome releases it last. 
+	*/
+	public:
+		static const unsigned int chunk_bits = 512; //a cache line of 8 words
+		static const unsigned int chunk_words = chunk_bits / 64;
+		static const unsigned int chunk_count = (B + chunk_bits - 1) / chunk_bits;
+		static const unsigned int padded_size = chunk_count * chunk_bits;
+		
+	private:
+		struct Chunk {
+			std::atomic<unsigned int> references;
+			bool hashed; //whether hash is current
+			std::uint64_t hash; //of bits
+			Chromosome<chunk_bits> bits;
+			
+			BlockPool* pool; //it was allocated from, NULL for the heap
+			
+			explicit Chunk(BlockPool* pPool) 
+				: references(1), hashed(false), hash(0), bits(), pool(pPool) {}
+		};
+		
+		std::array<Chunk*, chunk_count> chunks;
+		std::uint64_t hash_val; //of the chunk hashes, set by finish()
+		BlockPool* pool; //for new chunks
+		
+		static Chunk* make_chunk(BlockPool* pool);
+		static Chunk* acquire(Chunk* chunk);
+		static void release(Chunk* chunk);
+		Chunk& writable(const unsigned int c); //copies chunk c first if it is shared
+		
+	public:
+		explicit SharedChromosome(BlockPool* pPool=NULL); //all zero
+		SharedChromosome(const SharedChromosome& a, const SharedChromosome& b, 
+				 const unsigned int* points, const unsigned int count, 
+				 BlockPool* pPool=NULL);
+		SharedChromosome(const SharedChromosome& rhs) = delete;
+		SharedChromosome& operator=(const SharedChromosome& rhs) = delete;
+		~SharedChromosome();
+		
+		static constexpr unsigned int size() { return B; }
+		
+		bool operator[](const unsigned int i) const { return word(i/64) >> (i%64) & 1; }
+		std::uint64_t word(const unsigned int w) const { 
+			return chunks[w/chunk_words]->bits.data()[w%chunk_words]; 
+		}
+		std::uint64_t field(const unsigned int start, const unsigned int width) const;
+		
+		//for building; see class comment
+		void flip(const unsigned int i);
+		void assign(const unsigned int start, const unsigned int width, const std::uint64_t value);
+		void finish();
+		
+		std::uint64_t hash() const { return hash_val; } //of the contents, after finish()
+		unsigned int shared_chunks(const SharedChromosome& rhs) const; //count of same chunks
+		
+	}; //class SharedChromosome
+
+} //namespace john
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef SlotIndex_h
+#define SlotIndex_h
+
+/*
+    John: an evolutionary algorithm for genetic networks
+    Copyright (C) 2012  Jack Hall
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    e-mail: jackwhall7@gmail.com
+*/
+
+#include <vector>
+#include <cstdint>
+
+namespace john {
+
+	class SlotIndex {
+	/*
+		A SlotIndex maps Genotype IDs to slots in the dense arrays of a Fitness
+		object. It is an open addressing hash table with linear probing, kept in 
+		two flat arrays, so a lookup touches one or two cache lines and adding an
+		ID allocates nothing except when the table doubles. IDs are scattered with
+		a Fibonacci (multiplicative) hash, since consecutive IDs are the common 
+		case. Erasing shifts the rest of the probe run back instead of leaving a 
+		tombstone, so lookups never slow down as the population turns over. 
+	*/
+	public:
+		enum : unsigned int { npos = ~0u }; //returned for a missing ID; never a slot
+		
+	private:
+		std::vector<ID_type> keys;
+		std::vector<unsigned int> slots; //npos marks an empty bucket
+		unsigned int mask; //bucket count - 1, a power of two minus one
+		unsigned int shift; //64 - log2(bucket count)
+		unsigned int size_val;
+		
+		unsigned int bucket(const ID_type ID) const { 
+			return (std::uint64_t(ID) * 0x9E3779B97F4A7C15ull) >> shift; 
+		}
+		
+		void grow() {
+			std::vector<ID_type> old_keys;
+			std::vector<unsigned int> old_slots;
+			old_keys.swap(keys);
+			old_slots.swap(slots);
+			unsigned int buckets = 2*(mask + 1);
+			keys.assign(buckets, 0);
+			slots.assign(buckets, npos);
+			mask = buckets - 1;
+			--shift;
+			for(unsigned int i=0; i<old_slots.size(); ++i) {
+				if(old_slots[i] == npos) continue;
+				unsigned int b = bucket(old_keys[i]);
+				while(slots[b] != npos) b = (b + 1) & mask;
+				keys[b] = old_keys[i];
+				slots[b] = old_slots[i];
+			}
+		} //grow
+		
+	public:
+		SlotIndex() : keys(16, 0), slots(16, npos), mask(15), shift(60), size_val(0) {}
+		SlotIndex(const SlotIndex& rhs) = default;
+		SlotIndex& operator=(const SlotIndex& rhs) = default;
+		~SlotIndex() = default;
+		
+		unsigned int size() const { return size_val; }
+		bool empty() const { return size_val == 0; }
+		
+		unsigned int find(const ID_type ID) const {
+			for(unsigned int b=bucket(ID); slots[b] != npos; b = (b + 1) & mask) 
+				if(keys[b] == ID) return slots[b];
+			return npos;
+		} //find
+		
+		bool insert(const ID_type ID, const unsigned int slot) {
+			//returns false, changing nothing, if ID is already present
+			if(2*(size_val + 1) > mask + 1) grow(); //load factor stays <= 1/2
+			unsigned int b = bucket(ID);
+			for(; slots[b] != npos; b = (b + 1) & mask) 
+				if(keys[b] == ID) return false;
+			keys[b] = ID;
+			slots[b] = slot;
+			++size_val;
+			return true;
+		} //insert
+		
+		unsigned int erase(const ID_type ID) {
+			/*
+			Removes ID and returns its slot, or npos if it was not present. Later
+			entries of the probe run that would become unreachable through the new 
+			hole are moved back into it, one at a time. 
+			*/
+			unsigned int hole = bucket(ID);
+			for(; slots[hole] != npos; hole = (hole + 1) & mask) 
+				if(keys[hole] == ID) break;
+			if(slots[hole] == npos) return npos;
+			
+			unsigned int slot = slots[hole];
+			for(unsigned int b = (hole + 1) & mask; slots[b] != npos; b = (b + 1) & mask) {
+				//move b into the hole unless its home lies cyclically in (hole, b]
+				unsigned int home = bucket(keys[b]);
+				if( ((b - home) & mask) >= ((b - hole) & mask) ) {
+					keys[hole] = keys[b];
+					slots[hole] = slots[b];
+					hole = b;
+				}
+			}
+			slots[hole] = npos;
+			--size_val;
+			return slot;
+		} //erase
+		
+	}; //class SlotIndex
+
+} //namespace john
+
+#endif
+
@@ -0,0 +1,103 @@
+/*
+    John: an evolutionary algorithm for genetic networks
+    Copyright (C) 2012  Jack Hall
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    e-mail: jackwhall7@gmail.com
+*/
+
+namespace john {
+
+	template<typename T>
+	SumTree<T>::SumTree(const unsigned int nSize) 
+		: tree(nSize+1, 0), weights(nSize, 0), top_bit(0), updates(0) {
+		rebuild();
+	} //constructor
+	
+	template<typename T>
+	void SumTree<T>::rebuild() {
+		/*
+		Recomputes every partial sum from the raw weights in O(n). Repeated
+		floating point updates slowly accumulate rounding error in the partial 
+		sums, so set() calls this once per size() updates (amortized O(1)).
+		*/
+		unsigned int i, j, n = weights.size();
+		tree.assign(n+1, 0);
+		for(i=1; i<=n; ++i) {
+			tree[i] += weights[i-1];
+			j = i + (i & -i); //parent in the implicit tree
+			if(j <= n) tree[j] += tree[i];
+		}
+		
+		top_bit = 1;
+		while(top_bit <= n) top_bit <<= 1;
+		top_bit >>= 1; //zero if the tree is empty
+		updates = 0;
+	} //rebuild
+	
+	template<typename T>
+	T SumTree<T>::total() const {
+		T sum = 0;
+		for(unsigned int i=weights.size(); i>0; i -= (i & -i)) sum += tree[i];
+		return sum;
+	} //total
+	
+	template<typename T>
+	void SumTree<T>::resize(const unsigned int nSize) {
+		//new elements have zero weight; shrinking discards the trailing weights
+		weights.resize(nSize, 0);
+		rebuild();
+	} //resize
+	
+	template<typename T>
+	void SumTree<T>::set(const unsigned int index, T weight) {
+		/*
+		Changes the weight of one element. Negative weights cannot be sampled, 
+		so they are stored as zero. 
+		*/
+		if(weight < 0) weight = 0;
+		T delta = weight - weights[index];
+		weights[index] = weight;
+		
+		if(++updates > weights.size()) rebuild();
+		else {
+			unsigned int n = weights.size();
+			for(unsigned int i=index+1; i<=n; i += (i & -i)) tree[i] += delta;
+		}
+	} //set
+	
+	template<typename T>
+	unsigned int SumTree<T>::find(const T target) const {
+		/*
+		Returns the index of the element whose cumulative interval contains target,
+		which should lie in [0, total()). Elements with zero weight have empty 
+		intervals and are never returned. If rounding pushes target past the end,
+		the last index is returned; the caller is responsible for checking it.
+		*/
+		unsigned int pos = 0, next, n = weights.size();
+		T remaining = target;
+		for(unsigned int step=top_bit; step>0; step >>= 1) {
+			next = pos + step;
+			if(next <= n && tree[next] <= remaining) {
+				pos = next;
+				remaining -= tree[next];
+			}
+		}
+		if(pos >= n) pos = n - 1;
+		return pos; //pos is now the largest prefix length with sum <= target
+	} //find
+
+} //namespace john
+
@@ -0,0 +1,66 @@
+#ifndef SumTree_h
+#define SumTree_h
+
+/*
+    John: an evolutionary algorithm for genetic networks
+    Copyright (C) 2012  Jack Hall
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    e-mail: jackwhall7@gmail.com
+*/
+
+#include <vector>
+
+namespace john {
+
+	template<typename T>
+	class SumTree {
+	/*
+		A SumTree is a Fenwick (binary indexed) tree over a fixed number of 
+		non-negative weights. It supports changing one weight and finding the 
+		element at a given point in the cumulative distribution, both in O(log n).
+		Fitness uses it to pick parents in proportion to their values without 
+		polling the whole population for every selection. 
+	*/
+	private:
+		std::vector<T> tree; //partial sums, 1-based (tree[0] is unused)
+		std::vector<T> weights; //raw weights, 0-based
+		unsigned int top_bit; //largest power of two <= size()
+		unsigned int updates; //number of set() calls since the last rebuild
+		
+		void rebuild();
+		
+	public:
+		SumTree() : tree(1, 0), weights(), top_bit(0), updates(0) {}
+		explicit SumTree(const unsigned int nSize);
+		SumTree(const SumTree& rhs) = default;
+		SumTree& operator=(const SumTree& rhs) = default;
+		~SumTree() = default;
+		
+		unsigned int size() const { return weights.size(); }
+		T get(const unsigned int index) const { return weights[index]; }
+		const T* data() const { return weights.data(); } //all weights, in order
+		T total() const;
+		
+		void resize(const unsigned int nSize);
+		void set(const unsigned int index, T weight);
+		unsigned int find(const T target) const;
+		
+	}; //class SumTree
+
+} //namespace john
+
+#endif
+
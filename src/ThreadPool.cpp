@@ -0,0 +1,134 @@
+/*
+    John: an evolutionary algorithm for genetic networks
+    Copyright (C) 2012  Jack Hall
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    e-mail: jackwhall7@gmail.com
+*/
+
+#include "ThreadPool.h"
+
+namespace john {
+
+	thread_local unsigned int ThreadPool::index_val = 0;
+	
+	ThreadPool::ThreadPool(unsigned int nWorkers) 
+		: threads(), queues(), task(), remaining(0), job_lock(), 
+		  job_ready(), job_done(), epoch(0), stopping(false) {
+		if(nWorkers == 0) nWorkers = std::thread::hardware_concurrency();
+		if(nWorkers == 0) nWorkers = 1; //hardware_concurrency may not know
+		
+		for(unsigned int i=0; i<nWorkers; ++i) queues.emplace_back(new Queue);
+		for(unsigned int i=1; i<nWorkers; ++i) threads.emplace_back(&ThreadPool::work, this, i);
+	} //constructor
+	
+	ThreadPool::~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> guard(job_lock);
+			stopping = true;
+		}
+		job_ready.notify_all();
+		for(std::thread& thread : threads) thread.join();
+	} //destructor
+	
+	void ThreadPool::work(const unsigned int index) {
+		//loop of a pool thread: wait for a new loop, help finish it, repeat
+		index_val = index;
+		std::size_t seen = 0;
+		while(true) {
+			{
+				std::unique_lock<std::mutex> guard(job_lock);
+				job_ready.wait(guard, [&]{ return stopping || epoch != seen; });
+				if(stopping) return;
+				seen = epoch;
+			}
+			run_chunks(index);
+		}
+	} //work
+	
+	void ThreadPool::run_chunks(const unsigned int index) {
+		range_type range;
+		while( take(index, range) ) {
+			for(std::size_t i=range.first; i<range.second; ++i) task(i);
+			if(--remaining == 0) {
+				std::lock_guard<std::mutex> guard(job_lock);
+				job_done.notify_all();
+			}
+		}
+	} //run_chunks
+	
+	bool ThreadPool::take(const unsigned int index, range_type& range) {
+		/*
+		Takes the newest chunk of this worker's own deque, or failing that, steals
+		the oldest chunk of another worker's. Returns false if all are empty.
+		*/
+		{
+			Queue& own = *queues[index];
+			std::lock_guard<std::mutex> guard(own.lock);
+			if( !own.ranges.empty() ) {
+				range = own.ranges.back();
+				own.ranges.pop_back();
+				return true;
+			}
+		}
+		
+		unsigned int n = queues.size();
+		for(unsigned int k=1; k<n; ++k) {
+			Queue& victim = *queues[(index + k) % n];
+			std::lock_guard<std::mutex> guard(victim.lock);
+			if( !victim.ranges.empty() ) {
+				range = victim.ranges.front();
+				victim.ranges.pop_front();
+				return true;
+			}
+		}
+		return false;
+	} //take
+	
+	void ThreadPool::run(const std::size_t begin, const std::size_t end, std::size_t grain,
+			     std::function<void(std::size_t)> body) {
+		/*
+		The task and chunk count are set before any chunk is queued, so a worker 
+		still finishing the previous loop can only pick up chunks of this one 
+		after they are valid.
+		*/
+		if(begin >= end) return;
+		std::size_t n = queues.size(), count = end - begin;
+		if(grain == 0) grain = (count + 8*n - 1) / (8*n); //about 8 chunks per worker
+		
+		task = std::move(body);
+		remaining = (count + grain - 1) / grain;
+		std::size_t first, chunk = 0;
+		for(first=begin; first<end; first+=grain, ++chunk) {
+			Queue& queue = *queues[chunk % n];
+			std::lock_guard<std::mutex> guard(queue.lock);
+			queue.ranges.emplace_back(first, std::min(first + grain, end));
+		}
+		
+		{
+			std::lock_guard<std::mutex> guard(job_lock);
+			++epoch;
+		}
+		job_ready.notify_all();
+		
+		index_val = 0; //the caller is worker 0
+		run_chunks(0);
+		
+		std::unique_lock<std::mutex> guard(job_lock);
+		job_done.wait(guard, [&]{ return remaining == 0; });
+	} //run
+
+} //namespace john
+
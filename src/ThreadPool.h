@@ -0,0 +1,96 @@
+#ifndef ThreadPool_h
+#define ThreadPool_h
+
+/*
+    John: an evolutionary algorithm for genetic networks
+    Copyright (C) 2012  Jack Hall
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    e-mail: jackwhall7@gmail.com
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace john {
+
+	class ThreadPool {
+	/*
+		A ThreadPool runs parallel loops over index ranges with work stealing. 
+		parallel_for cuts the range into chunks and deals them out to one deque 
+		per worker; each worker takes chunks from the back of its own deque and, 
+		when that runs dry, steals from the front of the others'. The calling 
+		thread works as worker 0 until the loop is finished. 
+		
+		worker_index() tells code running inside a loop which worker it is on, so
+		that it can write to per-worker buffers without locking (see 
+		Fitness::defer). Loops must not be nested. 
+	*/
+	private:
+		typedef std::pair<std::size_t, std::size_t> range_type; //[first, second)
+		
+		struct Queue {
+			std::mutex lock;
+			std::deque<range_type> ranges;
+		};
+		
+		std::vector<std::thread> threads;
+		std::vector< std::unique_ptr<Queue> > queues; //one per worker, 0 is the caller
+		std::function<void(std::size_t)> task; //body of the current loop
+		std::atomic<std::size_t> remaining; //chunks of the current loop not yet done
+		std::mutex job_lock;
+		std::condition_variable job_ready, job_done;
+		std::size_t epoch; //number of loops started, so workers notice a new one
+		bool stopping;
+		
+		static thread_local unsigned int index_val;
+		
+		void work(const unsigned int index);
+		void run_chunks(const unsigned int index);
+		bool take(const unsigned int index, range_type& range);
+		void run(const std::size_t begin, const std::size_t end, std::size_t grain,
+			 std::function<void(std::size_t)> body);
+		
+	public:
+		explicit ThreadPool(unsigned int nWorkers=0); //0: one per hardware thread
+		ThreadPool(const ThreadPool& rhs) = delete;
+		ThreadPool& operator=(const ThreadPool& rhs) = delete;
+		~ThreadPool();
+		
+		unsigned int size() const { return queues.size(); } //workers, with the caller
+		static unsigned int worker_index() { return index_val; }
+		
+		//calls body(i) for every i in [begin, end); grain=0 picks a chunk size
+		template<typename F>
+		void parallel_for(const std::size_t begin, const std::size_t end, F body, 
+				  const std::size_t grain=0) {
+			run( begin, end, grain, std::function<void(std::size_t)>(body) );
+		}
+		
+	}; //class ThreadPool
+
+} //namespace john
+
+#endif
+
@@ -0,0 +1,103 @@
+#ifndef Xoshiro256_h
+#define Xoshiro256_h
+
+/*
+    John: an evolutionary algorithm for genetic networks
+    Copyright (C) 2012  Jack Hall
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    e-mail: jackwhall7@gmail.com
+*/
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+namespace john {
+
+	class Xoshiro256 {
+	/*
+		Xoshiro256** is a fast generator of 64-bit random words (Blackman and 
+		Vigna), with far better statistical quality than std::minstd_rand, which
+		only gives 31 bits per call. The state is seeded through SplitMix64, so 
+		nearby seeds such as consecutive IDs still give unrelated streams. It meets
+		the requirements of a uniform random bit generator, so it also works with 
+		the std distributions. 
+		
+		It can stand in for Philox as random_type (see John.h): a stream named by
+		(seed, generation, ID, purpose) is seeded from a hash of the four, but 
+		skipping ahead costs O(n). 
+	*/
+	public:
+		typedef std::uint64_t result_type;
+		
+	private:
+		std::array<std::uint64_t, 4> state;
+		
+		static std::uint64_t rotl(const std::uint64_t x, const int k) { 
+			return (x << k) | (x >> (64 - k)); 
+		}
+		
+	public:
+		explicit Xoshiro256(const std::uint64_t value=0) { seed(value); }
+		Xoshiro256(std::uint64_t value, const std::uint32_t generation, 
+			   const std::uint32_t ID, const Purpose purpose) {
+			//hash the four words into one seed, one word at a time
+			std::uint64_t hash = splitmix64(value) ^ ( (std::uint64_t(generation) << 32) | ID );
+			hash = splitmix64(hash) ^ static_cast<std::uint64_t>(purpose);
+			seed(hash);
+		}
+		Xoshiro256(const Xoshiro256& rhs) = default;
+		Xoshiro256& operator=(const Xoshiro256& rhs) = default;
+		~Xoshiro256() = default;
+		
+		static constexpr result_type min() { return 0; }
+		static constexpr result_type max() { return ~result_type(0); }
+		
+		static std::uint64_t splitmix64(std::uint64_t& x) {
+			std::uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+			return z ^ (z >> 31);
+		}
+		
+		void seed(std::uint64_t value) {
+			for(std::uint64_t& word : state) word = splitmix64(value); //never all zero
+		}
+		
+		result_type operator()() {
+			const std::uint64_t result = rotl(state[1] * 5, 7) * 9;
+			const std::uint64_t t = state[1] << 17;
+			state[2] ^= state[0];
+			state[3] ^= state[1];
+			state[1] ^= state[2];
+			state[0] ^= state[3];
+			state[2] ^= t;
+			state[3] = rotl(state[3], 45);
+			return result;
+		}
+		
+		void discard(std::uint64_t count) { while(count-- > 0) (*this)(); }
+		
+		void generate(std::uint64_t* out, std::size_t count) {
+			while(count-- > 0) *out++ = (*this)();
+		}
+		
+	}; //class Xoshiro256
+
+} //namespace john
+
+#endif
+